@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // fopencookie
 #include <stdio.h>
 #include <stdlib.h>
 #include <termios.h>
@@ -5,6 +6,32 @@
 #include <string.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <poll.h>
+#include <semaphore.h>
+#ifdef __linux__ // hot reload, the render thread & cookie streams, other systems run without them
+#include <sys/inotify.h>
+#include <stdio_ext.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TILE_KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define TILE_KERNELS_X86 0
+#endif
 
 #define MAX_LINE_LENGTH 1024
 #define MAX_PATH_LENGTH 128
@@ -21,23 +48,547 @@
 #define DARK_GRAY "\x1b[90m"
 #define PURPLE "\033[35m"
 
+#define CLEAR_SCREEN "\033[H\033[2J\033[3J" // what clear(1) prints, without spawning it
+#define SCREEN_TITLE "= = = = = = = = = = = =\n| " ORANGE "  _TEXT_ADVENTURE_  " RESET "|\n= = = = = = = = = = = =\n"
+#define SHOW_SCREEN(screen) show_screen(screen, sizeof(screen) - 1)
+
+#define WARRIOR_VISION 8 // how far a warrior sees, in tiles
+#define VISION_SIDE (2 * WARRIOR_VISION + 1) // the square around a warrior that its field of view can cover
+#define VISION_CACHE_SIZE 256 // cached fields of view per arena, direct mapped on the warrior's cell
+
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS) // slots per level of the timer wheel
+#define TIMER_LEVELS 4 // timers can be set up to 2^24 ticks ahead
+#define TIMER_POOL_SIZE 32 // pending timers per arena
+
+#define WARRIOR_CADENCE 1 // ticks between two moves of the warriors
+#define SPIKE_TICKS 2 // ticks a timed spike ('*') stays raised, then lowered
+#define WEAPON_TICKS 30 // ticks a weapon ('^' or ')') lasts once it is used
+#define DOOR_DELAY 3 // ticks between picking up a key and the doors opening
+
+#define MAX_BOSSES 4 // per arena
+#define BOSS_FRAMES 2 // animation frames of every boss shape
+#define BOSS_MAX_SIZE 8 // footprint rows, the columns fit in a byte
+#define BOSS_HEALTH 3 // weapon hits a boss takes
+#define BOSS_CADENCE 2 // ticks between two moves of the bosses
+
+#define ENTITY_BUCKET_BITS 3 // 8x8 tiles per bucket of the warrior grid
+
+#define GUI_LINES 5 // lines around the arena taken by the highscore, health and inventory bars
+
+#define BENCH_TARGET_NS 200000000 // time spent on every benchmark, at least one run
+#define BENCH_MAX_ITERATIONS 100000
+
 #define MAX_INVENTORY_ITEMS 3
 #define MAX_HEATH 115 
 
+typedef struct { // visible window of the arena, follows the player
+    int top;
+    int left;
+    int height;
+    int width;
+} Camera;
+
+typedef struct { // hookable allocator, every allocation of the game goes through game_malloc & co
+    void *(*malloc)(size_t size);
+    void *(*calloc)(size_t count, size_t size);
+    void *(*realloc)(void *ptr, size_t size);
+    void (*free)(void *ptr);
+} Allocator;
+
+typedef struct {
+    uint64_t allocs;    // malloc, calloc & realloc calls
+    uint64_t bytes;     // bytes asked for
+    uint64_t frees;
+} AllocStats;
+
+#define BUMP_BLOCK_SIZE 4096 // blocks after the first one
+
+typedef struct BumpBlock {
+    struct BumpBlock *next;
+    size_t size;
+    size_t used;
+    char data[];
+} BumpBlock;
+
+typedef struct { // bump allocator, everything is released at once
+    BumpBlock *blocks;  // newest first, only the newest one is filled
+    size_t next_block;
+} BumpAllocator;
+
+enum { // terrain codes, 4 bits per tile
+    TILE_EMPTY,
+    TILE_WALL,              // '='
+    TILE_SIDE_WALL,         // '|'
+    TILE_SPIKE,             // 'x'
+    TILE_HOLE,              // 'O'
+    TILE_SMALL_HOLE,        // 'o'
+    TILE_EXIT,              // '#'
+    TILE_EXIT_DOOR,         // 'D'
+    TILE_DOOR,              // 'd'
+    TILE_INFO,              // '!'
+    TILE_LEFT_TELEPORTER,   // '<'
+    TILE_RIGHT_TELEPORTER,  // '>'
+    TILE_WAVE,              // '~'
+    TILE_DOLLAR,            // '$'
+    TILE_TIMED_SPIKE,       // '*', only hurts while the spikes of the arena are raised
+    TILE_LABEL              // letters & digits drawn on the walls, the glyph is kept in the labels layer
+};
+
+#define TILE_GLYPHS " =|xOo#Dd!<>~$*" // glyph of every terrain code before TILE_LABEL
+#define ITEM_GLYPHS "kKc+^)" // pickups, kept in the items layer
+
+typedef struct { // sparse layer: cell index -> glyph (open addressing)
+    int *keys;      // -1 = empty slot
+    char *values;
+    int capacity;   // power of two
+    int count;
+    BumpAllocator *memory; // where the slots come from
+    uint64_t *hash;         // state hash every entry is folded into, NULL = none
+} CellMap;
+
+typedef struct {
+    int cell;
+    int next;   // next entity of the same bucket (or of the free list), -1 = end
+} Entity;
+
+typedef struct { // uniform bucket grid over the warriors, for radius queries and moves that only touch one or two buckets
+    int cols;           // of the arena
+    int bucket_cols;
+    int *buckets;       // first entity of every bucket, -1 = empty
+    Entity *entities;   // pool, grows like a CellMap
+    int capacity;
+    int free;           // first unused entity, -1 = pool full
+    BumpAllocator *memory;
+} EntityGrid;
+
+typedef struct { // footprint of a boss, one bitmap per animation frame (bit j of row i = the tile i rows down, j cols right of the anchor)
+    char glyph;     // marks the anchor (top left corner) in arena files
+    int height, width;
+    uint64_t frames[BOSS_FRAMES][BOSS_MAX_SIZE];
+} BossShape;
+
+typedef struct {
+    int shape;      // index in BOSS_SHAPES
+    int row, col;   // anchor
+    int frame;      // animation frame in use
+    int health;     // 0 = unused slot
+} Boss;
+
+typedef struct { // distance field over anchors, shared by every boss of one shape
+    uint64_t *fits; // rows x words, anchors where every frame of the footprint fits the passability layer
+    int *dist;      // rows x cols, moves until the footprint covers the player, -1 = never
+    int version;    // terrain version both fields were computed for, -1 = never
+    int target;     // player cell the distances lead to
+} BossPaths;
+
+typedef struct { // field of view of a warrior standing on `cell`, one bit per tile of the square around it
+    int cell;   // -1 = empty
+    uint64_t bits[(VISION_SIDE * VISION_SIDE + 63) / 64];
+} VisionEntry;
+
+typedef enum { // what a timer does when it fires, each arena has at most one pending timer of every kind
+    TIMER_FIGHTERS, // warriors move, then the timer is set again
+    TIMER_SPIKES,   // timed spikes go up or down
+    TIMER_WEAPON,   // the weapon buff runs out
+    TIMER_DOORS,    // doors open after the key was picked up
+    TIMER_BOSSES,   // bosses move and animate, then the timer is set again
+    TIMER_KIND_COUNT
+} TimerKind;
+
 typedef struct {
-    int row;
-    int col;
-} Point;
+    uint32_t expires;   // tick the timer fires on
+    int kind;
+    int data;           // left to the owner of the timer
+    int prev, next;     // slot list (next also links the free list), -1 = end
+    int slot;           // -1 = not pending
+} Timer;
+
+typedef struct { // hierarchical timer wheel, O(1) schedule & cancel, a tick only touches the timers that fire or cascade
+    uint32_t now;                               // ticks since the wheel was created
+    int slots[TIMER_LEVELS * TIMER_SLOTS];      // first timer of every slot, -1 = empty
+    Timer *timers;                              // TIMER_POOL_SIZE timers
+    int free;                                   // first unused timer, -1 = pool exhausted
+} TimerWheel;
+
+#define JOURNAL_MAGIC "TADELTA1"
+#define JOURNAL_FIRST_ENTRIES 64 // reserved with the arena, later growth comes from the level memory too
+#define JOURNAL_TICK_ENTRIES 4 // most entries & checkpoints one tick can add (a build + its checkpoint, the checkpoint of an undo)
+
+typedef struct { // terrain writes that can be undone, O(changes) for undo, redo, rewinds & deltas
+    uint64_t *entries;  // cell << 8 | old tile << 4 | new tile
+    int count;          // entries in effect, the ones up to `end` can be redone
+    int end;
+    int capacity;
+    int *marks;         // checkpoints (entry counts, marks[0] = 0), undo & redo stop on them
+    int mark_count;     // checkpoints in effect, the ones up to `mark_end` can be redone
+    int mark_end;
+    int mark_capacity;
+    int dirty_top, dirty_left, dirty_bottom, dirty_right; // tiles changed since journal_take_dirty, top > bottom = none
+} Journal;
+
+typedef struct { // first bytes of a delta file, followed by LEB128 zigzag cell steps + (old << 4 | new) bytes
+    char magic[8];
+    int32_t rows;
+    int32_t cols;
+    int32_t count;
+    int32_t reserved;
+} JournalHeader;
+
+#define MAX_TRIGGERS 256 // lines of a .triggers file
+#define MAX_TRIGGER_REGIONS 255 // distinct rectangles, a byte per cell holds the region
+
+typedef enum { TRIGGER_ENTER, TRIGGER_EXIT, TRIGGER_STAY, TRIGGER_EVENT_COUNT } TriggerEvent; // stay = moved inside the region
+typedef enum { TRIGGER_SCREEN, TRIGGER_SCORE, TRIGGER_COINS, TRIGGER_HEALTH, TRIGGER_BUY, TRIGGER_ACTION_COUNT } TriggerAction;
+
+typedef struct { // one line of a .triggers file
+    uint8_t event;
+    uint8_t action;
+    char item;          // buy: the consumable
+    int value;          // screen, points, coins, health or price
+} Trigger;
+
+typedef struct { // rows & columns inclusive, the triggers of a region are next to each other
+    int top, left, bottom, right;
+    int first;
+    int count;
+} TriggerRegion;
 
-typedef struct Node {
-    Point point;
-    struct Node *next;
-} Node;
+typedef struct {
+    int rows;
+    int cols;
+    int stride;             // bytes per terrain row, 2 tiles per byte
+    unsigned char *terrain; // packed 4-bit terrain codes
+    CellMap labels;         // wall letters & digits
+    CellMap items;          // keys, coins & consumables
+    CellMap warriors;       // enemies, O(1) occupancy
+    EntityGrid warrior_grid; // the same enemies, bucketed by position
+    int start_row;          // where 'p' was in the arena file
+    int start_col;
+    int *dist;              // fighters_bfs scratch, rows x cols
+    int *bfs_queue;         // every cell is queued at most once
+    int bfs_visited;        // cells the last search left in dist, everything else is -1
+    VisionEntry *vision;    // VISION_CACHE_SIZE fields of view, valid until the warrior moves or the terrain around it changes
+    int vision_count;       // entries in use
+    TimerWheel timers;      // everything the arena does later
+    int timer_of[TIMER_KIND_COUNT]; // pending timer of every kind, -1 = none
+    int spikes_raised;      // timed spikes hurt
+    uint64_t hash;          // zobrist key of the terrain & every layer, kept up to date by each write
+    int words;              // 64 bit words per row of the passability layer
+    uint64_t *passable;     // rows x words, tiles a boss can stand on
+    int terrain_version;    // bumped on every terrain change
+    int small;              // side of the fixed-size variant picked at load, 0 = generic paths
+    unsigned char *grid;    // small arenas: terrain codes bordered by side walls, (small + 2)^2 tiles
+    int grid_version;       // terrain_version the grid was copied at
+    unsigned char *region_of; // rows x cols, region + 1 of every cell, 0 = none, NULL = the arena has no triggers
+    TriggerRegion *regions;
+    int region_count;
+    Trigger *triggers;      // grouped by region
+    int trigger_count;
+    int trigger_cell;       // player cell the triggers last saw
+    int trigger_screen;     // screen a trigger asked for during the tick, -1 = none
+    Journal journal;        // undoable terrain writes (building)
+    Boss bosses[MAX_BOSSES]; // the first boss_count are alive, the rest is zeroed
+    int boss_count;
+    BossPaths *boss_paths;  // one per boss shape, filled in with the first boss of that shape
+    int *boss_queue;        // boss distance field scratch, rows x cols
+    BumpAllocator memory;   // holds the arena itself and everything above, freed with the level
+} Arena;
+
+typedef struct { // bulk operations on packed terrain, every set gives the same results
+    const char *name;
+    size_t (*count)(const unsigned char *tiles, size_t bytes, int tile);
+    long (*find)(const unsigned char *tiles, size_t bytes, size_t from, int tile); // nibble index, -1 = none
+    void (*replace)(unsigned char *tiles, size_t bytes, int from, int to);
+} TileKernels;
+
+#define CHUNK_SIZE 32 // tiles per chunk side
+#define CHUNK_BYTES (CHUNK_SIZE * CHUNK_SIZE)
+#define WORLD_MAGIC "TAWORLD1"
+#define WORLD_MIN_CHUNKS 9 // the 3x3 chunks around the player
+#define WORLD_DEFAULT_BUDGET (4 * 1024 * 1024) // bytes of resident chunks
+#define WORLD_GROW_TICKS 64 // world ticks between two growth stages, plants grow on every multiple
+#define WORLD_ORE_TICKS 600 // ticks until a mined ore vein comes back
+#define WORLD_FIRST_EVENTS 64
+#define WORLD_SEED '.'      // a tree that was cut down or planted, grows into a sapling
+#define WORLD_SAPLING ','   // grows into a tree
+#define WORLD_TREE 'T'
+#define WORLD_ORE '%'
+
+#define RLE_MAGIC "TARLE001"
+#define ARENA_MAX_SIDE 16384 // rows or columns of an arena file, anything bigger is refused
+
+typedef struct { // TA_HOT_RELOAD: the directory of the arena in play is watched, edits are patched into the live arena
+    int fd;                     // inotify, -1 = off
+    int watch;                  // -1 = no directory watched yet
+    char dir[MAX_PATH_LENGTH];  // watched directory
+    char path[MAX_PATH_LENGTH]; // arena file the text belongs to
+    char *text;                 // that file as it was last applied, to find the lines that changed
+    long length;
+} HotReload;
+
+typedef struct { // first bytes of a compressed arena, then every row up to a '\n': plain glyphs, or glyph | 0x80 + LEB128 run length
+    char magic[8];
+    int32_t rows;
+    int32_t cols;
+} RleHeader;
+
+typedef struct { // first bytes of a world file, followed by the chunks in row-major order
+    char magic[8];
+    int64_t rows;
+    int64_t cols;
+    int32_t chunk_size;
+    int32_t reserved;
+} WorldHeader;
+
+typedef struct { // after the chunks and one int64_t tick per chunk, followed by the pending events
+    int64_t tick;
+    int64_t events;
+} WorldTrailer;
+
+typedef struct { // something that happens at a given tick wherever the player is
+    int64_t tick;
+    int64_t row;
+    int64_t col;
+    int32_t glyph;      // put on the tile if it is still empty
+    int32_t reserved;
+} WorldEvent;
+
+typedef struct Chunk {
+    long index;                 // chunk number in the file, -1 = free slot
+    int64_t tick;               // world tick the tiles are up to date with
+    int dirty;                  // modified since it was loaded
+    int bucket_next;            // next slot in the same hash bucket
+    struct Chunk *prev, *next;  // lru list, most recently used at the front
+    char tiles[CHUNK_BYTES];
+} Chunk;
+
+typedef struct {
+    int fd;
+    long rows, cols;
+    long chunk_rows, chunk_cols;
+    Chunk *slots;       // resident chunks, never more than the memory budget
+    int slot_count;
+    int *buckets;       // chunk index -> slot
+    int bucket_mask;
+    Chunk *lru_front, *lru_back;
+    int64_t tick;       // the world only moves on through world_advance
+    WorldEvent *events; // min-heap on tick
+    int event_count;
+    int event_capacity;
+    long loads, evictions, writebacks;
+    long catch_ups, regrown, fired; // chunks brought up to date, plants that grew in them, events fired
+} World;
+
+#define TELEMETRY_PATH "telemetry.bin" // TA_TELEMETRY=1, anything else is the file
+#define TELEMETRY_MAGIC "TATELEM1"
+#define TELEMETRY_RING_SIZE 4096 // events the game can push between two drains, power of two
+#define TELEMETRY_FLUSH_NS 50000000 // how often the writer thread drains the ring
+
+typedef enum {
+    EVENT_LEVEL_START,      // value = 0
+    EVENT_LEVEL_COMPLETE,   // value = ms spent in the level
+    EVENT_SPIKE_DEATH,
+    EVENT_HOLE_DEATH,
+    EVENT_WARRIOR_DEATH,
+    EVENT_PICKUP,           // value = item glyph
+    EVENT_INPUT,            // value = key
+    EVENT_DROPPED,          // value = events lost to a full ring since the last one, written by the writer thread
+    EVENT_WARRIOR_KILL,
+    EVENT_BOSS_KILL,
+    EVENT_GAME_WON,
+    EVENT_COUNT
+} TelemetryEvent;
+
+typedef struct { // fixed-size binary event, the same in the ring and on disk (after an 8 byte magic)
+    uint64_t time;      // ns since the game started
+    uint16_t type;
+    uint16_t arena;     // current_arena
+    int32_t value;
+} TelemetryRecord;
+
+typedef struct { // single producer (game thread), single consumer (writer thread) ring
+    int enabled;
+    uint64_t start;
+    FILE *fp;
+    pthread_t writer;
+    _Alignas(64) _Atomic uint64_t head;     // next slot the game fills, written by the game only
+    _Alignas(64) _Atomic uint64_t tail;     // next slot the writer drains, written by the writer only
+    _Atomic uint64_t dropped;
+    _Atomic int stop;
+    TelemetryRecord ring[TELEMETRY_RING_SIZE];
+} Telemetry;
+
+#define RENDER_FRESH 4 // in RenderQueue.middle while the frame there hasn't been taken by the render thread
+
+typedef struct { // one composed frame, the buffer only grows
+    char *data;
+    size_t length;
+    size_t capacity;
+    uint64_t sequence;  // submit order
+} RenderFrame;
+
+typedef struct { // TA_RENDER_THREAD: the game composes frames, a render thread writes them to the terminal
+    int enabled;
+    RenderFrame frames[3];  // triple buffer: back is composed, middle is the newest finished frame, front is being written
+    int back;               // game thread only
+    int front;              // render thread only
+    _Atomic int middle;     // frame index | RENDER_FRESH, exchanged by both threads
+    sem_t ready;            // posted once per submitted frame
+    _Atomic int error;      // errno of a failed terminal write, the render thread stops & the game thread exits on it
+    _Atomic uint64_t written; // sequence of the last frame that reached the terminal
+    uint64_t submitted;     // sequence of the last submitted frame
+    FILE *stream;           // stdout while a frame is composed
+    FILE *terminal;         // stdout the rest of the time
+    pthread_t writer;
+} RenderQueue;
+
+#define TRACE_MAGIC "TATRACE1"
+
+typedef struct { // state hashes after one tick, the trace is an 8 byte magic and one record per tick
+    uint64_t world;     // terrain & layers (Arena.hash)
+    uint64_t player;    // position, health, inventory, flags, score, timers & bosses
+} TraceRecord;
+
+typedef struct {
+    FILE *fp;           // NULL = tracing is off
+    uint64_t ticks;
+    char buffer[64 * sizeof(TraceRecord)]; // records leave in batches, the stream never allocates
+} Trace;
+
+#define ACHIEVEMENTS_PATH "achievements.dat" // TA_ACHIEVEMENTS changes it
+#define ACHIEVEMENTS_MAGIC "TAACHV01"
+
+typedef enum {
+    ACHIEVE_COUNT,  // unlocked once `target` matching events were seen, over every session
+    ACHIEVE_BELOW   // unlocked by one matching event whose value is at most `target`
+} AchievementKind;
+
+typedef struct { // compiled predicate, new achievements go at the end (the unlocked bits are stored by index)
+    const char *name;
+    const char *description;
+    int event;      // TelemetryEvent it subscribes to
+    int filter;     // value the event must carry, 0 = any
+    int kind;
+    int target;
+} Achievement;
+
+typedef struct { // achievements with the same event, filter & kind share one counter, their targets are sorted
+    int event, filter, kind;
+    int64_t counter;    // matching events seen (ACHIEVE_COUNT)
+    int first;          // members in achievements.members
+    int count;
+    int next;           // ACHIEVE_COUNT: first member still locked, ACHIEVE_BELOW: members from here on are unlocked
+} AchievementGroup;
+
+typedef struct { // first bytes of the progress file, followed by the unlocked bits and one AchievementRecord per group
+    char magic[8];
+    int32_t achievements;
+    int32_t groups;
+} AchievementHeader;
+
+typedef struct {
+    int32_t event, filter, kind, reserved;
+    int64_t counter;
+} AchievementRecord;
+
+#define LEADERBOARD_PATH "leaderboard" // + .log (append-only) and .tbl (sorted), TA_LEADERBOARD changes it
+#define LEADERBOARD_LOG_MAGIC "TALOG001"
+#define LEADERBOARD_TABLE_MAGIC "TABOARD1"
+#define LEADERBOARD_LOG_LIMIT 1024 // log entries that trigger a compaction into the table
+
+typedef struct { // one finished run, same layout in the log and in the table
+    int64_t time;       // unix seconds
+    int32_t score;
+    int32_t coins;
+    int32_t arenas;     // arenas cleared
+    uint32_t crc;       // crc32 of the fields above, torn or damaged entries are skipped
+} LeaderboardEntry;
+
+typedef struct { // first bytes of both files, the log only counts while its generation matches the table's
+    char magic[8];
+    int64_t generation; // compactions so far
+    int64_t count;      // entries in the table, unused in the log
+} LeaderboardHeader;
+
+typedef struct { // the table mapped read-only + the log read and sorted in memory, under a flock of the log
+    int log_fd;
+    int64_t generation;
+    void *map;
+    size_t map_size;
+    const LeaderboardEntry *table; // best first
+    long table_count;
+    LeaderboardEntry *log;         // best first, at most LEADERBOARD_LOG_LIMIT + a few racing writers
+    long log_count;
+} Leaderboard;
+
+typedef enum { // what happened during one tick of the game rules
+    TICK_CONTINUE,
+    TICK_INFO,
+    TICK_SPIKE_DEATH,
+    TICK_WARRIOR_DEATH,
+    TICK_HOLE_DEATH,
+    TICK_ARENA_EXIT
+} TickResult;
+
+typedef enum { // timed parts of a frame, fighters is also counted inside rules
+    PHASE_RENDER,
+    PHASE_INPUT,
+    PHASE_RULES,
+    PHASE_FIGHTERS,
+    PHASE_LOAD,
+    PHASE_COUNT
+} ProfilePhase;
+
+typedef enum {
+    COUNTER_ALLOCS,
+    COUNTER_ALLOC_BYTES,
+    COUNTER_BYTES_WRITTEN,
+    COUNTER_BFS_NODES,
+    COUNTER_VISION_CASTS,
+    COUNTER_FRAMES_DROPPED,
+    COUNTER_COUNT
+} ProfileCounter;
+
+#define HISTOGRAM_SUB_BUCKETS 16 // linear buckets per power of two
+#define HISTOGRAM_BUCKETS (61 * HISTOGRAM_SUB_BUCKETS) // enough for any 64 bit value
+
+typedef struct { // log-linear latency histogram (HdrHistogram style), values in ns
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total, sum, min, max;
+} Histogram;
 
-typedef struct Queue {
-    Node *front;
-    Node *rear;
-} Queue;
+typedef struct {
+    int enabled;
+    int used;                           // enabled at least once ~ write the report on exit
+    const char *report_path;            // NULL = profile.txt
+    uint64_t last[PHASE_COUNT];         // ns spent in each phase the last time it ran
+    uint64_t frame[COUNTER_COUNT];      // counters of the frame in progress
+    uint64_t last_frame[COUNTER_COUNT];
+    uint64_t totals[COUNTER_COUNT];
+    uint64_t frames;
+    Histogram phases[PHASE_COUNT];
+    uint64_t phase_allocs[PHASE_COUNT];
+    uint64_t phase_alloc_bytes[PHASE_COUNT];
+} Profiler;
+
+typedef struct { // where a timed phase started
+    uint64_t start;     // 0 = the profiler was off
+    uint64_t allocs;
+    uint64_t bytes;
+} ProfileScope;
+
+// timers & counters cost a single branch while the profiler is off
+#define PROFILE_BEGIN() (profiler.enabled ? profile_begin() : (ProfileScope){0})
+#define PROFILE_END(phase, scope) do { if ((scope).start) profile_end(phase, &(scope)); } while (0)
+#define PROFILE_COUNT(counter, n) do { if (profiler.enabled) profiler.frame[counter] += (n); } while (0)
+
+// a single branch while telemetry is off, never blocks or allocates while it is on
+#define TELEMETRY(type, value) do { if (telemetry.enabled) telemetry_push(type, value); } while (0)
+// gameplay events go to telemetry and to the achievements subscribed to them (neither is on in the solver or the benchmarks)
+#define GAME_EVENT(type, value) do { TELEMETRY(type, value); if (achievements.loaded) achievements_on(type, value); } while (0)
+// the arena hash is always kept up to date, a tick only combines & writes it while a trace is open
+#define TRACE_TICK(arena, x, y) do { if (trace.fp) trace_tick(arena, x, y); } while (0)
 
 /*
     GLOBAL VARIABLES
@@ -62,42 +613,246 @@ int exit_arena = 0; // counts how many enemies and exit keys are required to ope
 
 int row_dir[] = {-1, 1, 0, 0}; // directions for enemies
 int col_dir[] = {0, 0, -1, 1};
+int facing = 0; // direction of the player's last move, walls are built there
+
+Camera camera = {0, 0, 0, 0};
+volatile sig_atomic_t terminal_resized = 1; // set on SIGWINCH, the terminal size is read again before the next frame
+int terminal_rows = 0; // 0 = unknown size (output is not a terminal)
+int terminal_cols = 0;
+
+Profiler profiler;
+const char *PHASE_NAMES[PHASE_COUNT] = {"render", "input", "rules", "fighters", "load"};
+const char *COUNTER_NAMES[COUNTER_COUNT] = {"allocs", "alloc bytes", "bytes written", "bfs nodes", "vision casts", "dropped frames"};
+
+Telemetry telemetry;
+Trace trace;
+HotReload hot_reload = { .fd = -1, .watch = -1 };
+RenderQueue render;
+
+const Achievement ACHIEVEMENTS[] = {
+    {"First Coin", "pick up a coin", EVENT_PICKUP, 'c', ACHIEVE_COUNT, 1},
+    {"Coin Collector", "pick up 50 coins", EVENT_PICKUP, 'c', ACHIEVE_COUNT, 50},
+    {"Hoarder", "pick up 500 coins", EVENT_PICKUP, 'c', ACHIEVE_COUNT, 500},
+    {"First Blood", "defeat a warrior", EVENT_WARRIOR_KILL, 0, ACHIEVE_COUNT, 1},
+    {"Warrior Slayer", "defeat 25 warriors", EVENT_WARRIOR_KILL, 0, ACHIEVE_COUNT, 25},
+    {"Army of One", "defeat 250 warriors", EVENT_WARRIOR_KILL, 0, ACHIEVE_COUNT, 250},
+    {"Giant Killer", "defeat a boss", EVENT_BOSS_KILL, 0, ACHIEVE_COUNT, 1},
+    {"Way Out", "clear an arena", EVENT_LEVEL_COMPLETE, 0, ACHIEVE_COUNT, 1},
+    {"Veteran", "clear 25 arenas", EVENT_LEVEL_COMPLETE, 0, ACHIEVE_COUNT, 25},
+    {"Speedrunner", "clear an arena in under 10 seconds", EVENT_LEVEL_COMPLETE, 0, ACHIEVE_BELOW, 10000},
+    {"Lightning", "clear an arena in under 3 seconds", EVENT_LEVEL_COMPLETE, 0, ACHIEVE_BELOW, 3000},
+    {"Pincushion", "die on a spike", EVENT_SPIKE_DEATH, 0, ACHIEVE_COUNT, 1},
+    {"Into the Abyss", "fall into a hole", EVENT_HOLE_DEATH, 0, ACHIEVE_COUNT, 1},
+    {"Outnumbered", "get caught by warriors 10 times", EVENT_WARRIOR_DEATH, 0, ACHIEVE_COUNT, 10},
+    {"Medic", "pick up 10 health potions", EVENT_PICKUP, '+', ACHIEVE_COUNT, 10},
+    {"Armed", "pick up a weapon", EVENT_PICKUP, '^', ACHIEVE_COUNT, 1},
+    {"Keymaster", "pick up 20 exit keys", EVENT_PICKUP, 'K', ACHIEVE_COUNT, 20},
+    {"Champion", "clear the last arena", EVENT_GAME_WON, 0, ACHIEVE_COUNT, 1},
+};
+#define ACHIEVEMENT_COUNT (int)(sizeof(ACHIEVEMENTS) / sizeof(ACHIEVEMENTS[0]))
+
+struct {
+    int loaded;                         // progress was read, events are counted
+    int dirty;                          // progress changed since the last save
+    const char *banner;                 // last unlock, shown under the gui for one frame
+    AchievementGroup groups[ACHIEVEMENT_COUNT];
+    int group_count;
+    int members[ACHIEVEMENT_COUNT];     // achievement ids by group, then by target
+    int first_group[EVENT_COUNT + 1];   // groups of event e: [first_group[e], first_group[e + 1])
+    unsigned char unlocked[(ACHIEVEMENT_COUNT + 7) / 8];
+} achievements;
+const char *EVENT_NAMES[EVENT_COUNT] = {"level_start", "level_complete", "spike_death", "hole_death", "warrior_death", "pickup", "input", "dropped",
+    "warrior_kill", "boss_kill", "game_won"};
+
+TileKernels tile_kernels; // set by tile_kernels_init
+
+const BossShape BOSS_SHAPES[] = {
+    {'&', 3, 3, {{0b010, 0b111, 0b101}, {0b010, 0b111, 0b010}}}, // ogre, legs apart / together
+};
+#define BOSS_SHAPE_COUNT (int)(sizeof(BOSS_SHAPES) / sizeof(BOSS_SHAPES[0]))
+
+Allocator allocator = { malloc, calloc, realloc, free };
+AllocStats alloc_stats;
+int alloc_guard = 0; // set while a gameplay tick runs, only checked by TA_ALLOC_CHECK
 
 /*
     FUNCTION PROTOTYPES 
 */
 void start_game(); // game loop
 
+void arena_path(const char *file_name, char *path); // pre_build_arenas/<file>, names with a '/' are used as they are
 void get_arena_dimensions(const char *file_name, int *rows, int *cols); // determines the rows and cols of the arena
-char** create_arena(int rows, int cols); // allocates memory for the arena
-void free_arena(char **arena, int rows); // frees the allocated memory
-void initialize_arena(char **arena, int rows, int cols, const char *filename); // initializes the arena from the file
-void print_arena(char **arena, int rows, int cols); 
-void initialize_game(char ***arena, int *rows, int *cols, int *player_x, int *player_y); // dimensions + create + init + player position
+Arena* create_arena(int rows, int cols); // allocates memory for the arena
+void free_arena(Arena *arena); // frees the whole level at once
+void initialize_arena(Arena *arena, int rows, int cols, const char *filename); // initializes the arena from the file
+void print_arena(Arena *arena, int rows, int cols, int player_x, int player_y); // prints the camera window of the arena
+void update_camera(int rows, int cols, int player_x, int player_y); // centers the camera on the player, sized from the terminal
+void initialize_game(Arena **arena, int *rows, int *cols, int *player_x, int *player_y); // dimensions + create + init + player position
 void set_arena_files(char **files, int count); // allocates memory for arena files
-
-void print_gui(char **arena, int rows, int cols); // gui + game window
+int arenas_cleared(int upto); // arenas before arena_files[upto] that count for the leaderboard
+long arena_compress(const char *file_name, const char *path); // text arena -> .rle file, returns its size, -1 = error
+int run_compress(int count, char *args[]); // --compress
+
+void cellmap_init(CellMap *map, BumpAllocator *memory, uint64_t *hash);
+char cellmap_get(const CellMap *map, int cell); // '\0' if the cell is not in the map
+void cellmap_put(CellMap *map, int cell, char value);
+void cellmap_remove(CellMap *map, int cell);
+void entity_grid_init(EntityGrid *grid, int rows, int cols, BumpAllocator *memory);
+void warrior_add(Arena *arena, int cell); // warriors layer + grid
+void warrior_remove(Arena *arena, int cell);
+void warrior_move(Arena *arena, int from, int to); // the target must be free
+int warriors_near(Arena *arena, int row, int col, int radius, int *cells, int max); // warriors within `radius` tiles, up to max
+int terrain_at(Arena *arena, int row, int col); // 4-bit terrain code
+void set_terrain(Arena *arena, int row, int col, int tile);
+char arena_tile(Arena *arena, int row, int col); // what the rules see on a tile: warrior > item > terrain
+void arena_put(Arena *arena, int row, int col, char glyph); // sorts a glyph from an arena file into its layer
+void place_player(Arena *arena, int player_x, int player_y); // warriors on the tile of an armed player are killed
+int arena_snapshot_size(Arena *arena);
+void save_arena_snapshot(Arena *arena, char *snapshot); // terrain & item glyphs + warrior bitmap
+void load_arena_snapshot(Arena *arena, const char *snapshot);
+
+void tile_kernels_init(); // picks the fastest supported kernel set
+int tile_kernels_supported(const TileKernels *kernels);
+long count_terrain(Arena *arena, int tile);
+int find_terrain(Arena *arena, int tile, long *from, int *row, int *col); // next tile of a kind in reading order, 0 = none left
+void replace_terrain(Arena *arena, int from, int to);
+
+void print_gui(Arena *arena, int rows, int cols, int player_x, int player_y); // gui + game window
 void print_player_health(int health); // prints player health
 void print_inventory(char items[]); // prints the invetory and items
 void handle_highscore_coins(int score, int coins); // prints highscore & collected coins
-void handle_tutorials(); // displays the right tutorial based on the arena
-int process_player_inputs(int *player_x, int *player_y, char **arena, int rows, int cols); // takes keyboard inputs
+void handle_triggers(Arena *arena); // shows the screen a trigger asked for
+int process_player_inputs(int *player_x, int *player_y, Arena *arena, int rows, int cols); // takes keyboard inputs
+void move_player(char input, int *player_x, int *player_y, Arena *arena, int rows, int cols); // applies one movement / inventory key
 int is_inventory_full(char items[]); 
-void handle_inventory_slot(char *item_slot);  // activates the consumables
-void handle_arena_exit(char **arena, int rows, int cols); // unlocks the door after collecting the key + eliminating all threats
-void handle_consumable(char consumable, int *flag, int player_x, int player_y, char **arena); // helper function for checking which consumable is picked
-void update_arena_character(char character, int *flag, int player_x, int player_y, char **arena); // updates the previous position the player was on
-
-void reset_current_arena(char ***arena, int *rows, int *cols, int *player_x, int *player_y);
-void reset_flags(int *over_spike, int *exit_game, int *death_flag, int *weapon_flag,
-                int *over_health_consumable, int *over_attack_consumable, int *over_info, int *over_small_hole);
-
-Queue* create_queue();
-void enqueue(Queue *queue, Point point);
-Point dequeue(Queue *queue);
-int is_empty(Queue *queue);
-void fighters_bfs(char **arena, int rows, int cols, int player_x, int player_y, int dist[rows][cols]);
-void move_fighters(char **arena, int rows, int cols, int player_x, int player_y);
+void handle_inventory_slot(Arena *arena, char *item_slot);  // activates the consumables
+void handle_arena_exit(Arena *arena); // unlocks the door after collecting the key + eliminating all threats
+void handle_consumable(char consumable, int player_x, int player_y, Arena *arena); // helper function for checking which consumable is picked
+TickResult apply_game_rules(Arena *arena, int *player_x, int *player_y); // rules for the tile the player moved on
+TickResult simulate_tick(Arena *arena, int rows, int cols, int *player_x, int *player_y, char input); // one headless game tick
+
+int triggers_path(const char *file_name, char *path); // <arena>.triggers next to the arena file, 0 = the path is too long
+void triggers_load(Arena *arena, const char *file_name); // replaces the triggers of the arena with its .triggers file, if there is one
+int triggers_step(Arena *arena, int player_x, int player_y); // enter / exit / stay once the player changed cells, 1 = a screen is pending
+
+void reset_current_arena(Arena **arena, int *rows, int *cols, int *player_x, int *player_y);
+void reset_flags(int *exit_game, int *death_flag, int *weapon_flag);
+
+int warrior_sees(Arena *arena, int cell, int player_x, int player_y); // shadowcast field of view, cached per warrior
+void vision_invalidate(Arena *arena, int row, int col); // the terrain changed there, warriors around it look again
+void vision_reset(Arena *arena); // forgets every field of view
+void timers_init(TimerWheel *wheel, BumpAllocator *memory);
+int timer_schedule(TimerWheel *wheel, int delay, int kind, int data); // fires `delay` ticks from now (at least 1), -1 = pool exhausted
+void timer_cancel(TimerWheel *wheel, int id);
+int timer_remaining(TimerWheel *wheel, int id); // ticks until the timer fires, 0 = not pending
+void timers_tick(TimerWheel *wheel); // moves the wheel one tick forward
+int timer_pop_due(TimerWheel *wheel, Timer *timer); // takes out the next timer of the current tick, 0 = none left
+void arena_schedule(Arena *arena, int kind, int delay); // replaces the pending timer of that kind
+void arena_cancel(Arena *arena, int kind);
+void arena_tick(Arena *arena, int player_x, int player_y); // one game tick: fires every timer that is due
+
+void journal_init(Journal *journal, BumpAllocator *memory);
+void journal_reserve(Arena *arena); // room for the writes of one tick, so a tick never allocates
+void journal_set(Arena *arena, int row, int col, int tile); // set_terrain + an entry, drops whatever could be redone
+int journal_checkpoint(Arena *arena); // closes the current step, returns its checkpoint
+int journal_undo(Arena *arena); // back to the previous checkpoint, 0 = nothing to undo
+int journal_redo(Arena *arena); // forward to the next checkpoint, 0 = nothing to redo
+void journal_rewind(Arena *arena, int checkpoint); // undoes every step after it
+int journal_take_dirty(Arena *arena, int *top, int *left, int *bottom, int *right); // bounds of the tiles changed since the last call, 0 = none
+long journal_save(Arena *arena, const char *path); // net changes against the arena file, returns the size, -1 = error
+int journal_load(Arena *arena, const char *path); // applies a delta onto the freshly loaded arena, 0 = it does not fit
+int build_wall(Arena *arena, int player_x, int player_y); // on the empty tile the player faces, 0 = nothing built
+int run_apply_delta(int count, char *args[]); // --apply-delta
+
+void passability_rebuild(Arena *arena); // after bulk terrain writes
+int footprint_fits(Arena *arena, const uint64_t *frame, int height, int row, int col); // word-wide test against the passability layer
+int boss_at(Arena *arena, int row, int col); // boss covering the tile, -1 = none
+void boss_add(Arena *arena, int shape, int row, int col);
+void boss_remove(Arena *arena, int index);
+void boss_hit(Arena *arena, int index); // the player has a weapon
+void move_bosses(Arena *arena, int player_x, int player_y);
+
+void fighters_bfs(Arena *arena, int rows, int cols, int player_x, int player_y, const int *goals, int goal_count); // distances in arena->dist, stops once every goal is reached
+void move_fighters(Arena *arena, int rows, int cols, int player_x, int player_y);
+int small_arena_side(int rows, int cols); // fixed-size variant an arena of that size gets, 0 = none
+int small_move_fighters(Arena *arena, int player_x, int player_y); // 0 = not a small arena, the generic path has to run
+int small_arena_exit(Arena *arena);
+
+World* world_create(const char *path, long rows, long cols); // creates an empty world file
+World* world_open(const char *path, long budget); // opens a world file with a resident memory budget in bytes
+char world_get(World *world, long row, long col);
+void world_set(World *world, long row, long col, char tile); // marks the chunk dirty
+void world_focus(World *world, long row, long col, int radius); // loads the chunks around a position
+void world_flush(World *world); // writes back every dirty chunk
+void world_close(World *world);
+World* world_import_arena(const char *file_name, const char *path); // converts a text arena into a world file
+void world_advance(World *world); // one tick: fires the events that are due, chunks catch up when they are next used
+void world_schedule(World *world, int delay, long row, long col, char glyph); // puts the glyph on the tile `delay` ticks from now
+char world_gather(World *world, long row, long col); // takes a tree or an ore vein, '\0' = nothing there
+int run_world_sim(int count, char *args[]); // --world-sim
+int run_make_world(int count, char *args[]); // --make-world
+
+void *game_malloc(size_t size); // counted, then handed to the hooked allocator
+void *game_calloc(size_t count, size_t size);
+void *game_realloc(void *ptr, size_t size);
+void game_free(void *ptr);
+void alloc_check_init(); // TA_ALLOC_CHECK ~ exit on any allocation inside a gameplay tick
+void bump_init(BumpAllocator *bump, size_t first_block);
+void *bump_alloc(BumpAllocator *bump, size_t size);
+void bump_release(BumpAllocator *bump); // frees every block
+
+uint64_t monotonic_ns();
+ProfileScope profile_begin();
+void profile_end(int phase, ProfileScope *scope);
+void profiler_init(); // enables the profiler when TA_PROFILE is set
+void profile_toggle(); // 'p' key
+void profile_record(int phase, uint64_t ns);
+void profile_frame_end(); // closes the counters of the current frame
+void print_profile_overlay(); // one line under the gui while profiling
+void profiler_dump(); // percentiles + histograms of every phase, on exit
+
+void telemetry_init(); // starts the writer thread when TA_TELEMETRY is set
+void telemetry_push(int type, int value); // drops the event when the ring is full
+void telemetry_shutdown(); // drains the ring and joins the writer, on exit
+int run_telemetry(int count, char *args[]); // --telemetry, log -> csv / json
+
+void achievements_init(); // compiles the predicates and reads the progress file
+void achievements_on(int type, int value); // only the groups subscribed to the event are touched
+void achievements_save(); // temp file + rename
+void print_achievement_banner(); // one line under the gui after an unlock
+int run_achievements(int count, char *args[]); // --achievements
+
+int leaderboard_record(int score, int coins, int arenas); // appends a finished run, compacts the log when it is full, -1 = error
+int leaderboard_open(Leaderboard *board, int lock); // LOCK_SH to read, LOCK_EX to write
+void leaderboard_close(Leaderboard *board);
+int leaderboard_top(Leaderboard *board, int k, LeaderboardEntry *out); // best k runs, returns how many were found
+long leaderboard_rank(Leaderboard *board, int score); // 1 + runs with a higher score, O(log n) over the table
+int run_leaderboard(int count, char *args[]); // --leaderboard
+
+int run_solver(int count, char *files[]); // solves arena files in parallel (--solve)
+void solve_arena(const char *file_name, char *report, size_t report_len); // A* search over the game states of one arena
+
+int run_batch(int count, char *args[]); // --batch, replays a directory of input scripts on every core
+
+void hot_reload_init(); // TA_HOT_RELOAD=1 watches the arena files
+int hot_reload_wait(Arena **arena, int *rows, int *cols, int *player_x, int *player_y); // until a key is pressed (0) or the arena was patched (1)
+
+void render_init(); // TA_RENDER_THREAD=1 hands the terminal writes to a render thread
+void render_begin(); // what is printed from here on is the next frame
+void render_submit(); // passes the frame on, a frame the terminal hasn't taken yet is dropped
+void render_drain(); // waits until the last submitted frame is on the terminal
+
+uint64_t state_key(int cell, int value); // zobrist key of a glyph or terrain code on a cell
+uint64_t terrain_key(int cell, int tile); // 0 for empty tiles, so a new arena hashes to 0
+uint64_t state_hash(Arena *arena, int player_x, int player_y); // arena hash + everything the player carries, O(1)
+int trace_open(const char *path); // per-tick state hashes go to the file, 0 = it could not be created
+void trace_tick(Arena *arena, int player_x, int player_y);
+void trace_close();
+void trace_init(); // TA_TRACE=<file> traces the game
+int run_trace_diff(int count, char *args[]); // --trace-diff, first tick where two traces disagree
+
+int run_benchmarks(int count, char *args[]); // --bench, synthetic arenas up to 4096x4096
+int run_selftest(int count, char *args[]); // --selftest, deterministic checks of the solver, file formats & kernels
 
 void display_main_menu();
 int display_pause_menu();
@@ -115,6 +870,8 @@ void display_hole_death();
 void display_warrior_death();
 void display_exit_message();
 void display_win();
+int trigger_screen(const char *name); // screen a trigger can show, -1 = unknown
+void display_trigger_screen(int screen);
 void ask_about_tutorial();
 
 /* 
@@ -146,6 +903,7 @@ void show_cursor() {
 }
 
 void cleanup() {
+    render_drain(); // the last frame goes out before the terminal is restored
     disable_raw_mode();
     show_cursor();  
 }
@@ -155,24 +913,78 @@ void handle_sigint(int sig) {
     exit(EXIT_SUCCESS);
 }
 
+void handle_sigwinch(int sig) {
+    terminal_resized = 1;
+}
+
+void read_terminal_size() { // rows & cols of the terminal window
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == -1 || !size.ws_row || !size.ws_col) {
+        terminal_rows = terminal_cols = 0;
+        return;
+    }
+    terminal_rows = size.ws_row;
+    terminal_cols = size.ws_col;
+}
+
 void clear_console() { // clears the console screan based on OS
     #ifdef _WIN32
         system("cls");
     #elif __unix__ || __APPLE__
-        system("clear");
+        fputs(CLEAR_SCREEN, stdout); // goes out with the next frame
     #else
         printf("console clearing not supported on this platform.\n");
     #endif
 }
 
+void show_screen(const char *screen, size_t len) { // precomposed screen (clear sequence included) in one write
+    render_drain(); // after the frames
+    fflush(stdout); // whatever is buffered goes first
+    PROFILE_COUNT(COUNTER_BYTES_WRITTEN, len);
+    while (len) {
+        ssize_t written = write(STDOUT_FILENO, screen, len);
+        if (written == -1) {
+            perror("Error writing screen");
+            exit(EXIT_FAILURE);
+        }
+        screen += written;
+        len -= written;
+    }
+}
+
 /* 
     MAIN FUNCTION
 */
-int main() {
+int main(int argc, char *argv[]) {
+
+    tile_kernels_init();
+
+    if (argc > 1 && !strcmp(argv[1], "--solve")) return run_solver(argc - 2, argv + 2); // headless level validation
+    if (argc > 1 && !strcmp(argv[1], "--compress")) return run_compress(argc - 2, argv + 2); // run-length encoded arenas
+    if (argc > 1 && !strcmp(argv[1], "--apply-delta")) return run_apply_delta(argc - 2, argv + 2); // arena + building delta as text
+    if (argc > 1 && !strcmp(argv[1], "--make-world")) return run_make_world(argc - 2, argv + 2); // chunked world files
+    if (argc > 1 && !strcmp(argv[1], "--world-sim")) return run_world_sim(argc - 2, argv + 2); // lazy survival simulation on a world file
+    if (argc > 1 && !strcmp(argv[1], "--bench")) return run_benchmarks(argc - 2, argv + 2); // hot path timings as JSON
+    if (argc > 1 && !strcmp(argv[1], "--selftest")) return run_selftest(argc - 2, argv + 2); // solver, file format & kernel checks
+    if (argc > 1 && !strcmp(argv[1], "--leaderboard")) return run_leaderboard(argc - 2, argv + 2); // top runs & ranks
+    if (argc > 1 && !strcmp(argv[1], "--telemetry")) return run_telemetry(argc - 2, argv + 2); // telemetry log reader
+    if (argc > 1 && !strcmp(argv[1], "--batch")) return run_batch(argc - 2, argv + 2); // replays scripts & recorded sessions headless
+    if (argc > 1 && !strcmp(argv[1], "--trace-diff")) return run_trace_diff(argc - 2, argv + 2); // determinism check between two runs
+    if (argc > 1 && !strcmp(argv[1], "--achievements")) return run_achievements(argc - 2, argv + 2); // progress of every achievement
 
     signal(SIGINT, handle_sigint);
+    signal(SIGTERM, handle_sigint); // exit() ~ atexit handlers run when the game is killed too
+    signal(SIGHUP, handle_sigint);
+    signal(SIGWINCH, handle_sigwinch);
     
     atexit(cleanup);
+    profiler_init();
+    telemetry_init();
+    achievements_init();
+    trace_init();
+    hot_reload_init();
+    render_init();
+    alloc_check_init();
 
     enable_raw_mode();
 
@@ -189,150 +1001,85 @@ int main() {
 void start_game() {
   
     int rows, cols;
-    char **arena;
+    Arena *arena;
     int player_x, player_y; // coordinates for player
 
+    ProfileScope start = PROFILE_BEGIN();
     initialize_game(&arena, &rows, &cols, &player_x, &player_y);
+    PROFILE_END(PHASE_LOAD, start);
+    uint64_t level_start = monotonic_ns();
+    GAME_EVENT(EVENT_LEVEL_START, 0);
 
     if(!current_arena && played_tutorial) display_tutorial_movement();
     
-    char input; // stores keyboard input
-    
     // flag for stoping the loop
     int exit_game = 0;
-    // flags for knowing when the player is on top of items
-    int over_spike = 0;
-    int over_health_consumable = 0; 
-    int over_attack_consumable = 0;
-    int over_defense_consumable = 0;
-    int over_info = 0;
-    int over_small_hole = 0;
-    int over_left_teleporter = 0;
-    int over_right_teleporter = 0;
-
-    bool teleported = false;
 
     while (!exit_game) { 
 
         exit_arena = 0;
-        handle_arena_exit(arena, rows, cols); // unlock exit door if all threats are eliminated
+        handle_arena_exit(arena); // unlock exit door if all threats are eliminated
 
-        print_gui(arena, rows, cols); // game window + gui
+        start = PROFILE_BEGIN();
+        render_begin();
+        print_gui(arena, rows, cols, player_x, player_y); // game window + gui
+        PROFILE_END(PHASE_RENDER, start);
+        print_profile_overlay();
+        print_achievement_banner();
+        render_submit(); // with a render thread the next tick runs while this frame is written
+        profile_frame_end();
 
         block_input = 0;
-    
-        /* UPDATE ARENA CONSUMABLES AND TRAPS */
-        arena[player_x][player_y] = ' ';
-        update_arena_character('x', &over_spike, player_x, player_y, arena);
-        update_arena_character('!', &over_info, player_x, player_y, arena);
-        update_arena_character('o', &over_small_hole, player_x, player_y, arena);
-        update_arena_character('^', &over_attack_consumable, player_x, player_y, arena);
-        update_arena_character('(', &over_defense_consumable, player_x, player_y, arena);
-        update_arena_character('+', &over_health_consumable, player_x, player_y, arena);
-        update_arena_character('<', &over_left_teleporter, player_x, player_y, arena);
-        update_arena_character('>', &over_right_teleporter, player_x, player_y, arena);
-
-        teleported = false;
+        if (hot_reload.fd != -1 && !death_flag && hot_reload_wait(&arena, &rows, &cols, &player_x, &player_y)) continue; // edited ~ show it first
     
         /* INPUT AND PLAYER INTERACTIONS */
+        journal_reserve(arena); // building in the tick writes into it
+        alloc_guard = 1; // the arena is loaded, a tick needs no new memory
+        start = PROFILE_BEGIN();
         if (!death_flag) exit_game = process_player_inputs(&player_x, &player_y, arena, rows, cols);
+        PROFILE_END(PHASE_INPUT, start);
         if (exit_game) {
+            alloc_guard = 0;
             current_arena = 0; 
             reset_current_arena(&arena, &rows, &cols, &player_x, &player_y);
             continue;   // if the user leaves the game, skip the rest of the loop
         }
 
-        if (arena[player_x][player_y] == 'x') { // -30 health if the player is on top of a spike
-            if (!block_input) player_h -= 30; 
-            over_spike = 1; 
-        }
-
-        if ((arena[player_x][player_y] == 'w' || death_flag) && !weapon_flag) { // if player position = w position & the player has no weapon,
-            player_h -= 200;                                                    // he dies, oth the warrior dies
-            death_flag = 1;                                                
-        }
-
-        if (player_h <= 0 && (strstr(arena_files[current_arena], "arena") || strstr(arena_files[current_arena], "test"))) { // if health reaches 0 ~ death flag and break the loop
-            current_arena = 0;
-            if (over_spike) display_spike_death();
-            else if (death_flag) display_warrior_death(); 
-            reset_flags(&over_spike, &exit_game, &death_flag, &weapon_flag, &over_health_consumable, &over_attack_consumable, &over_info, &over_small_hole);
-            reset_current_arena(&arena, &rows, &cols, &player_x, &player_y);
-            break; 
-        }
-        else if (player_h <= 0 && strstr(arena_files[current_arena], "tutorial")) {
-            reset_flags(&over_spike, &exit_game, &death_flag, &weapon_flag, &over_health_consumable, &over_attack_consumable, &over_info, &over_small_hole);
-            reset_current_arena(&arena, &rows, &cols, &player_x, &player_y); // reset the tutorial
-            display_tutorial_fail();
-            continue; // skip this game loop iteration
-        }
-
-        if (arena[player_x][player_y] == 'O' && (strstr(arena_files[current_arena], "arena") || strstr(arena_files[current_arena], "test"))) { // fall in hole ~ instant death
-            current_arena = 0;
-            reset_flags(&over_spike, &exit_game, &death_flag, &weapon_flag, &over_health_consumable, &over_attack_consumable, &over_info, &over_small_hole);
-            reset_current_arena(&arena, &rows, &cols, &player_x, &player_y);
-            display_hole_death();
-            break; 
-        }
-        else if (arena[player_x][player_y] == 'O' && strstr(arena_files[current_arena], "tutorial")) {
-            reset_flags(&over_spike, &exit_game, &death_flag, &weapon_flag, &over_health_consumable, &over_attack_consumable, &over_info, &over_small_hole);
-            reset_current_arena(&arena, &rows, &cols, &player_x, &player_y); // reset the tutorial
-            display_tutorial_fail();
-            continue; // skip this game loop iteration
-        }
-
-        if (arena[player_x][player_y] == 'o') { // touching a small hole ~ lose all your items
-            over_small_hole = 1;
-            for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
-        }
-        
-        handle_consumable('+', &over_health_consumable, player_x, player_y, arena);
-        handle_consumable('^', &over_attack_consumable, player_x, player_y, arena);
-        handle_consumable(')', &over_defense_consumable, player_x, player_y, arena); 
-
-        if (arena[player_x][player_y] == 'k' || arena[player_x][player_y] == 'K') {
-            for (int i = 0; i < rows; i++) { // change 'd' to ' ' after the key is picked
-                for (int j = 0; j < cols; j++) if (arena[i][j] == 'd') arena[i][j] = ' ';
+        start = PROFILE_BEGIN();
+        TickResult result = apply_game_rules(arena, &player_x, &player_y);
+        PROFILE_END(PHASE_RULES, start);
+        alloc_guard = 0;
+        if (result == TICK_CONTINUE || result == TICK_INFO) place_player(arena, player_x, player_y); // update player location on the arena, as simulate_tick does
+        TRACE_TICK(arena, player_x, player_y); // after place_player in both loops, so live & batch traces line up
+        if (achievements.banner || (achievements.dirty && result != TICK_CONTINUE)) achievements_save(); // unlocks & level ends, never inside a tick
+
+        if (result == TICK_SPIKE_DEATH || result == TICK_WARRIOR_DEATH || result == TICK_HOLE_DEATH) {
+            GAME_EVENT(result == TICK_SPIKE_DEATH ? EVENT_SPIKE_DEATH : result == TICK_HOLE_DEATH ? EVENT_HOLE_DEATH : EVENT_WARRIOR_DEATH, 0);
+            if (strstr(arena_files[current_arena], "arena") || strstr(arena_files[current_arena], "test")) { // death ~ break the loop
+                leaderboard_record(score, coins, arenas_cleared(current_arena)); // the run is over, a full disk only costs the entry
+                current_arena = 0;
+                if (result == TICK_SPIKE_DEATH) display_spike_death();
+                else if (result == TICK_WARRIOR_DEATH) display_warrior_death(); 
+                reset_flags(&exit_game, &death_flag, &weapon_flag);
+                reset_current_arena(&arena, &rows, &cols, &player_x, &player_y);
+                if (result == TICK_HOLE_DEATH) display_hole_death();
+                break; 
+            }
+            else if (strstr(arena_files[current_arena], "tutorial")) {
+                reset_flags(&exit_game, &death_flag, &weapon_flag);
+                reset_current_arena(&arena, &rows, &cols, &player_x, &player_y); // reset the tutorial
+                level_start = monotonic_ns();
+                GAME_EVENT(EVENT_LEVEL_START, 0);
+                display_tutorial_fail();
+                continue; // skip this game loop iteration
             }
         }
 
-        if (arena[player_x][player_y] == '!') {
-            over_info = 1;
-            if (!block_input) handle_tutorials(); // print tutorial message based on the current tutorial arena
-        }
-
-        if (arena[player_x][player_y] == 'c') { coins++; score += 50; }
-
-        if (arena[player_x][player_y] == '<' && !teleported) { 
-            over_right_teleporter = 1;
-            for (int i = 0; i < rows; i++) { 
-                for (int j = 0; j < cols; j++) {
-                    if ((arena)[i][j] == '>') {
-                        player_x = i;
-                        player_y = j;
-                    }
-                }
-            } 
-            teleported = true;    
-        }
-
-        if (arena[player_x][player_y] == '>' && !teleported) {
-            over_left_teleporter = 1;
-            for (int i = 0; i < rows; i++) { 
-                for (int j = 0; j < cols; j++) {
-                    if ((arena)[i][j] == '<') {
-                        player_x = i;
-                        player_y = j;
-                    }
-                }
-            }  
-            teleported = true;
-        }
-
-        if (!block_input) move_fighters(arena, rows, cols, player_x, player_y);
+        if (result == TICK_INFO) handle_triggers(arena); // tutorial message of the info tile the player stepped on
   
         /* LOAD NEXT ARENA */
-        if (arena[player_x][player_y] == '#') {
+        if (result == TICK_ARENA_EXIT) {
+            GAME_EVENT(EVENT_LEVEL_COMPLETE, (int)((monotonic_ns() - level_start) / 1000000));
             score += 200;
             if (current_arena + 1 < num_arenas) { // check if next arena is valid
                 current_arena++;  // move to the next arena
@@ -345,34 +1092,97 @@ void start_game() {
                     for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
                 }
 
-                reset_flags(&over_spike, &exit_game, &death_flag, &weapon_flag, &over_health_consumable, &over_attack_consumable, &over_info, &over_small_hole);
-                free_arena(arena, rows); // current area freed
+                reset_flags(&exit_game, &death_flag, &weapon_flag);
+                start = PROFILE_BEGIN();
+                free_arena(arena); // current area freed
                 initialize_game(&arena, &rows, &cols, &player_x, &player_y); // initialize the next arena
+                PROFILE_END(PHASE_LOAD, start);
+                level_start = monotonic_ns();
+                GAME_EVENT(EVENT_LEVEL_START, 0);
             } 
             else { // last arena
+                leaderboard_record(score, coins, arenas_cleared(num_arenas));
+                GAME_EVENT(EVENT_GAME_WON, score);
+                achievements_save();
                 current_arena = 0;
                 display_win(); // win message after the last arena
-                reset_flags(&over_spike, &exit_game, &death_flag, &weapon_flag, &over_health_consumable, &over_attack_consumable, &over_info, &over_small_hole);
+                reset_flags(&exit_game, &death_flag, &weapon_flag);
                 player_h = 100;
                 for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
                 coins = 0; score = 0;
                 break;
             }
         }
-
-        arena[player_x][player_y] = 'p'; // update player location on the arena
     }
 
-    free_arena(arena, rows);
+    free_arena(arena);
     clear_console();
 }
 
 /*
     ARENA FUNCTIONS
 */
+void arena_path(const char *file_name, char *path) {
+    if (strchr(file_name, '/')) snprintf(path, MAX_PATH_LENGTH, "%s", file_name);
+    else snprintf(path, MAX_PATH_LENGTH, "pre_build_arenas/%s", file_name);
+
+    size_t length = strlen(path);
+    if (length > 4 && !strcmp(path + length - 4, ".txt") && access(path, F_OK)) { // only the compressed arena is there
+        memcpy(path + length - 4, ".rle", 4);
+        if (access(path, F_OK)) memcpy(path + length - 4, ".txt", 4); // neither ~ errors name the text file
+    }
+}
+
+static int rle_read_header(FILE *fp, RleHeader *header, const char *path) { // 0 = a text arena, read from the start
+    if (fread(header, sizeof(*header), 1, fp) != 1 || memcmp(header->magic, RLE_MAGIC, 8)) {
+        rewind(fp);
+        return 0;
+    }
+    if (header->rows < 0 || header->cols < 0 || header->rows > ARENA_MAX_SIDE || header->cols > ARENA_MAX_SIDE) {
+        fprintf(stderr, "%s: damaged arena header (%dx%d)\n", path, header->rows, header->cols);
+        exit(EXIT_FAILURE);
+    }
+    return 1;
+}
+
+static long rle_read_count(FILE *fp) { // LEB128, -1 = truncated file
+    long count = 0;
+    int shift = 0, c;
+    do {
+        if ((c = getc(fp)) == EOF || shift > 28) return -1;
+        count |= (long)(c & 0x7F) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    return count;
+}
+
+static void rle_write_count(FILE *fp, long count) {
+    do {
+        putc((count & 0x7F) | (count > 0x7F ? 0x80 : 0), fp);
+        count >>= 7;
+    } while (count);
+}
+
+static void rle_decode(Arena *arena, int rows, int cols, FILE *fp) { // run by run straight into the layers, no text is ever built
+    for (int i = 0; i < rows; i++) {
+        int j = 0, glyph;
+        while ((glyph = getc(fp)) != EOF && glyph != '\n') {
+            long run = 1;
+            if (glyph & 0x80) {
+                glyph &= 0x7F;
+                if ((run = rle_read_count(fp)) < 0) return; // truncated ~ the rest stays empty
+            }
+            if (run > cols - j) run = cols - j;
+            if (glyph == ' ') j += run; // a new arena is empty already
+            else for (long end = j + run; j < end; j++) arena_put(arena, i, j, glyph);
+        }
+        if (glyph == EOF) return;
+    }
+}
+
 void get_arena_dimensions(const char *file_name, int *rows, int *cols) { 
     char path[MAX_PATH_LENGTH];
-    snprintf(path, sizeof(path), "pre_build_arenas/%s", file_name);
+    arena_path(file_name, path);
 
     FILE *fp = fopen(path, "r");
     if (!fp) {
@@ -380,11 +1190,20 @@ void get_arena_dimensions(const char *file_name, int *rows, int *cols) {
         exit(EXIT_FAILURE);
     }
 
-    char line[MAX_LINE_LENGTH];
+    RleHeader header;
+    if (rle_read_header(fp, &header, path)) { // the size is stored, nothing to scan
+        *rows = header.rows;
+        *cols = header.cols;
+        fclose(fp);
+        return;
+    }
+
+    char *line = NULL; // grown by getline, lines can be longer than MAX_LINE_LENGTH
+    size_t capacity = 0;
     *rows = 0;
     *cols = 0;
 
-    while (fgets(line, sizeof(line), fp)) { // read through each line
+    while (getline(&line, &capacity, fp) != -1) { // read through each line
         (*rows)++;
         int length = strcspn(line, "\n"); // get line length ~ exluding '\n'
         if (length > *cols) {
@@ -392,36 +1211,95 @@ void get_arena_dimensions(const char *file_name, int *rows, int *cols) {
         }
     }
 
+    free(line);
     fclose(fp);
+    if (*rows > ARENA_MAX_SIDE || *cols > ARENA_MAX_SIDE) {
+        fprintf(stderr, "%s: arena larger than %dx%d\n", path, ARENA_MAX_SIDE, ARENA_MAX_SIDE);
+        exit(EXIT_FAILURE);
+    }
 }
 
-char** create_arena(int rows, int cols) { 
-    char **arena = (char **)malloc(rows * sizeof(char *));
-    if (arena == NULL) {
-        perror("malloc");
+static size_t arena_bytes(size_t *total, size_t count, size_t size) { // count * size, also added to *total ~ exits if either overflows
+    if ((size && count > SIZE_MAX / size) || count * size > SIZE_MAX - *total) {
+        fprintf(stderr, "create_arena: arena too large\n");
         exit(EXIT_FAILURE);
     }
+    *total += count * size;
+    return count * size;
+}
 
-    for (int i = 0; i < rows; i++) { // allocate memory for each row
-        arena[i] = (char *)malloc(cols * sizeof(char));
-        if (arena[i] == NULL) {
-            perror("malloc");
-            for (int j = 0; j < i; j++) free(arena[j]); // free previously allocated memory in case of error
-            free(arena);
-            exit(EXIT_FAILURE);
-        }
+Arena* create_arena(int rows, int cols) { // one bump allocator holds the whole level
+    if (rows < 0 || cols < 0) {
+        fprintf(stderr, "create_arena: negative size %dx%d\n", rows, cols);
+        exit(EXIT_FAILURE);
     }
+    int stride = (cols + 1) / 2;
+    int words = (cols + 63) / 64;
+    int small = small_arena_side(rows, cols);
+    size_t total = sizeof(Arena) + (size_t)(small + 2) * (small + 2) + VISION_CACHE_SIZE * sizeof(VisionEntry) + TIMER_POOL_SIZE * sizeof(Timer) +
+        3 * 16 * (sizeof(int) + 1) + JOURNAL_FIRST_ENTRIES * (sizeof(uint64_t) + sizeof(int)) + 256; // fixed parts
+    size_t unused = 0;
+    size_t cells = arena_bytes(&unused, rows, cols);
+    size_t terrain_bytes = arena_bytes(&total, rows, stride);
+    size_t passable_bytes = arena_bytes(&total, arena_bytes(&unused, rows, words), sizeof(uint64_t));
+    size_t cell_bytes = arena_bytes(&total, cells, sizeof(int));
+    arena_bytes(&total, cells, sizeof(int)); // bfs queue
+    arena_bytes(&total, arena_bytes(&unused, (rows >> ENTITY_BUCKET_BITS) + 1, (cols >> ENTITY_BUCKET_BITS) + 1) + 2 * 16, sizeof(int));
+    BumpAllocator memory;
+    bump_init(&memory, total);
+
+    Arena *arena = (Arena *)bump_alloc(&memory, sizeof(Arena));
+    arena->memory = memory;
+    arena->rows = rows;
+    arena->cols = cols;
+    arena->stride = stride;
+    arena->terrain = (unsigned char *)bump_alloc(&arena->memory, terrain_bytes);
+    memset(arena->terrain, 0, terrain_bytes); // every tile starts as TILE_EMPTY
+    arena->dist = (int *)bump_alloc(&arena->memory, cell_bytes);
+    arena->bfs_queue = (int *)bump_alloc(&arena->memory, cell_bytes);
+    memset(arena->dist, 0xFF, cell_bytes); // -1 = not visited
+    arena->bfs_visited = 0;
+    arena->vision = (VisionEntry *)bump_alloc(&arena->memory, VISION_CACHE_SIZE * sizeof(VisionEntry));
+    vision_reset(arena);
+    timers_init(&arena->timers, &arena->memory);
+    for (int i = 0; i < TIMER_KIND_COUNT; i++) arena->timer_of[i] = -1;
+    arena->spikes_raised = 1;
+    arena->words = words;
+    arena->passable = (uint64_t *)bump_alloc(&arena->memory, passable_bytes);
+    memset(arena->passable, 0xFF, passable_bytes);
+    for (int i = 0; i < rows && cols % 64; i++) arena->passable[i * words + words - 1] = (1ull << (cols % 64)) - 1; // nothing past the last column
+    arena->terrain_version = 0;
+    arena->small = small;
+    arena->grid = small ? (unsigned char *)bump_alloc(&arena->memory, (small + 2) * (small + 2)) : NULL;
+    arena->grid_version = -1; // copied on first use
+    journal_init(&arena->journal, &arena->memory);
+    memset(arena->bosses, 0, sizeof(arena->bosses));
+    arena->boss_count = 0;
+    arena->boss_paths = NULL;
+    arena->boss_queue = NULL;
+    arena->hash = 0; // empty tiles add nothing
+    cellmap_init(&arena->labels, &arena->memory, &arena->hash);
+    cellmap_init(&arena->items, &arena->memory, &arena->hash);
+    cellmap_init(&arena->warriors, &arena->memory, &arena->hash);
+    entity_grid_init(&arena->warrior_grid, rows, cols, &arena->memory);
+    arena->start_row = arena->start_col = 0;
+    arena->region_of = NULL;
+    arena->regions = NULL;
+    arena->triggers = NULL;
+    arena->region_count = arena->trigger_count = 0;
+    arena->trigger_cell = 0;
+    arena->trigger_screen = -1;
     return arena;
 }
 
-void free_arena(char **arena, int rows) {
-    for (int i = 0; i < rows; i++) free(arena[i]);
-    free(arena);
+void free_arena(Arena *arena) {
+    BumpAllocator memory = arena->memory; // the arena lives in its own memory
+    bump_release(&memory);
 }
 
-void initialize_arena(char **arena, int rows, int cols, const char *file_name) { 
+void initialize_arena(Arena *arena, int rows, int cols, const char *file_name) { 
     char path[MAX_PATH_LENGTH];
-    snprintf(path, sizeof(path), "pre_build_arenas/%s", file_name);
+    arena_path(file_name, path);
 
     FILE *fp = fopen(path, "r");
     if (!fp) {
@@ -429,85 +1307,603 @@ void initialize_arena(char **arena, int rows, int cols, const char *file_name) {
         exit(EXIT_FAILURE);
     }
     
-    char line[MAX_LINE_LENGTH];
-    for (int i = 0; i < rows; i++) {
-        if (fgets(line, sizeof(line), fp)) {
-            int length = strcspn(line, "\n");
-            for (int j = 0; j < cols; j++) {
-                if (j < length) {
-                    arena[i][j] = line[j];
-                } else {
-                    arena[i][j] = ' ';  // fill with spaces if line is shorter than expected
-                }
+    RleHeader header;
+    if (rle_read_header(fp, &header, path)) rle_decode(arena, rows, cols, fp);
+    else {
+        char *line = NULL;
+        size_t capacity = 0;
+        for (int i = 0; i < rows; i++) {
+            if (getline(&line, &capacity, fp) != -1) {
+                int length = strcspn(line, "\n");
+                for (int j = 0; j < cols && j < length; j++) arena_put(arena, i, j, line[j]); // missing tiles stay empty
             }
-        } else {
-            // fill the rest of the arena with spaces if file has fewer lines
-            for (int j = 0; j < cols; j++) {
-                arena[i][j] = ' ';
+        }
+        free(line);
+    }
+    fclose(fp);
+
+    if (arena->warriors.count) arena_schedule(arena, TIMER_FIGHTERS, WARRIOR_CADENCE); // warriors only ever get fewer
+    if (count_terrain(arena, TILE_TIMED_SPIKE)) arena_schedule(arena, TIMER_SPIKES, SPIKE_TICKS);
+    if (arena->boss_count) arena_schedule(arena, TIMER_BOSSES, BOSS_CADENCE);
+    triggers_load(arena, file_name);
+    arena->trigger_cell = arena->start_row * cols + arena->start_col; // regions fire once the player moves
+}
+
+long arena_compress(const char *file_name, const char *path) {
+    int rows, cols;
+    char source[MAX_PATH_LENGTH];
+    arena_path(file_name, source);
+    get_arena_dimensions(file_name, &rows, &cols);
+
+    FILE *in = fopen(source, "r");
+    FILE *out = fopen(path, "wb");
+    if (!in || !out) {
+        perror(!in ? source : path);
+        if (in) fclose(in);
+        if (out) fclose(out);
+        return -1;
+    }
+    RleHeader header = { RLE_MAGIC, rows, cols };
+    fwrite(&header, sizeof(header), 1, out);
+
+    char *line = NULL;
+    size_t capacity = 0;
+    int ascii = 1;
+    for (int i = 0; i < rows && ascii && getline(&line, &capacity, in) != -1; i++) {
+        int length = strcspn(line, "\n");
+        while (length && line[length - 1] == ' ') length--; // trailing spaces are the default
+        for (int j = 0; j < length && ascii; ) {
+            int end = j + 1;
+            while (end < length && line[end] == line[j]) end++;
+            if (line[j] & 0x80) ascii = 0; // the high bit marks runs
+            else if (end - j == 1) putc(line[j], out);
+            else {
+                putc(line[j] | 0x80, out);
+                rle_write_count(out, end - j);
             }
+            j = end;
         }
+        putc('\n', out); // end of the row
+    }
+    free(line);
+    fclose(in);
+    if (!ascii) {
+        fprintf(stderr, "%s: only ascii glyphs can be compressed\n", source);
+        fclose(out);
+        unlink(path);
+        return -1;
     }
 
-    fclose(fp);
+    long size = ftell(out);
+    if (fclose(out)) {
+        perror(path);
+        return -1;
+    }
+    return size;
 }
 
-void print_arena(char **arena, int rows, int cols) { 
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            if (arena[i][j] == 'w') printf("%s%c %s", BRIGHT_RED, arena[i][j], RESET); // enemies ~ BRIGHT_RED
-            else if (arena[i][j] == 'x' || arena[i][j] == 'O' || arena[i][j] == 'o') printf("%s%c %s", RED, arena[i][j], RESET); // traps ~ RED)
-            else if (arena[i][j] == '#' || arena[i][j] == 'K' || arena[i][j] == 'k' || arena[i][j] == '!' || arena[i][j] == '~' || 
-                arena[i][j] == '<' || arena[i][j] == '>' || arena[i][j] == 'c' || arena[i][j] == '$') printf("%s%c %s", YELLOW, arena[i][j], RESET); // exit ~ YELLOW
-            else if (arena[i][j] == '+' || arena[i][j] == '^' || arena[i][j] == ')') printf("%s%c %s", GREEN, arena[i][j], RESET); // consumables ~ GREEN
-            else if (arena[i][j] == 'p' || arena[i][j] == '0' || arena[i][j] == '1' || arena[i][j] == '2' || 
-                arena[i][j] == '3' || arena[i][j] == '4' || arena[i][j] == '5' || arena[i][j] == '6' || arena[i][j] == '7' || 
-                arena[i][j] == '8' || arena[i][j] == '9' || arena[i][j] == 'A' || arena[i][j] == 'R' || arena[i][j] == 'E' || 
-                arena[i][j] == 'N' || arena[i][j] == 'T' || arena[i][j] == 'U' || arena[i][j] == 'R' || arena[i][j] == 'I' || 
-                arena[i][j] == 'L' || arena[i][j] == 'W' || arena[i][j] == 'H' || arena[i][j] == 'V' || arena[i][j] == 'F' ||
-                arena[i][j] == 'C' || arena[i][j] == 'M' ) printf("%s%c %s", CYAN, arena[i][j], RESET); // player ~ CYAN
-            else if (arena[i][j] == 'D' || arena[i][j] == 'd') printf("%s%c %s", DARK_GRAY, arena[i][j], RESET); // doors ~ DARK_GRAY
-            else printf("%c ", arena[i][j]); // rest of elements ~ REGULAR
+int run_compress(int count, char *args[]) {
+    if (count < 1) {
+        fprintf(stderr, "usage: --compress <arena files> ~ writes <name>.rle next to every file\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < count; i++) {
+        char source[MAX_PATH_LENGTH], path[MAX_PATH_LENGTH];
+        arena_path(args[i], source);
+        size_t length = strlen(source);
+        if (length < 4 || strcmp(source + length - 4, ".txt")) {
+            fprintf(stderr, "%s: not a text arena\n", source);
+            return EXIT_FAILURE;
+        }
+        snprintf(path, sizeof(path), "%.*s.rle", (int)length - 4, source);
+
+        struct stat text;
+        long size = arena_compress(args[i], path);
+        if (size < 0 || stat(source, &text)) return EXIT_FAILURE;
+        printf("%s: %lld -> %ld bytes\n", path, (long long)text.st_size, size);
+    }
+    return EXIT_SUCCESS;
+}
+
+void print_arena(Arena *arena, int rows, int cols, int player_x, int player_y) { 
+    for (int i = camera.top; i < camera.top + camera.height && i < rows; i++) {
+        for (int j = camera.left; j < camera.left + camera.width && j < cols; j++) {
+            char tile = i == player_x && j == player_y ? 'p' : arena_tile(arena, i, j);
+            if (tile == 'w' || tile == '&') printf("%s%c %s", BRIGHT_RED, tile, RESET); // enemies ~ BRIGHT_RED
+            else if (tile == '*') printf("%s%c %s", arena->spikes_raised ? RED : DARK_GRAY, tile, RESET); // timed spikes ~ RED while raised
+            else if (tile == 'x' || tile == 'O' || tile == 'o') printf("%s%c %s", RED, tile, RESET); // traps ~ RED)
+            else if (tile == '#' || tile == 'K' || tile == 'k' || tile == '!' || tile == '~' || 
+                tile == '<' || tile == '>' || tile == 'c' || tile == '$') printf("%s%c %s", YELLOW, tile, RESET); // exit ~ YELLOW
+            else if (tile == '+' || tile == '^' || tile == ')') printf("%s%c %s", GREEN, tile, RESET); // consumables ~ GREEN
+            else if (tile == 'p' || tile == '0' || tile == '1' || tile == '2' || 
+                tile == '3' || tile == '4' || tile == '5' || tile == '6' || tile == '7' || 
+                tile == '8' || tile == '9' || tile == 'A' || tile == 'R' || tile == 'E' || 
+                tile == 'N' || tile == 'T' || tile == 'U' || tile == 'R' || tile == 'I' || 
+                tile == 'L' || tile == 'W' || tile == 'H' || tile == 'V' || tile == 'F' ||
+                tile == 'C' || tile == 'M' ) printf("%s%c %s", CYAN, tile, RESET); // player ~ CYAN
+            else if (tile == 'D' || tile == 'd') printf("%s%c %s", DARK_GRAY, tile, RESET); // doors ~ DARK_GRAY
+            else printf("%c ", tile); // rest of elements ~ REGULAR
         }
         printf("\n");
     }
 }
 
-void initialize_game(char ***arena, int *rows, int *cols, int *player_x, int *player_y) {
+void update_camera(int rows, int cols, int player_x, int player_y) {
+    if (terminal_resized) {
+        terminal_resized = 0;
+        read_terminal_size();
+    }
+
+    camera.height = rows;
+    camera.width = cols;
+    int gui_lines = GUI_LINES + profiler.enabled + (achievements.banner != NULL); // + the profiler overlay & the achievement banner
+    if (terminal_rows && terminal_rows - gui_lines < rows) camera.height = terminal_rows - gui_lines > 1 ? terminal_rows - gui_lines : 1;
+    if (terminal_cols && terminal_cols / 2 < cols) camera.width = terminal_cols / 2 > 1 ? terminal_cols / 2 : 1; // 2 columns per tile
+
+    camera.top = player_x - camera.height / 2; // keep the player in the middle, without leaving the arena
+    if (camera.top > rows - camera.height) camera.top = rows - camera.height;
+    if (camera.top < 0) camera.top = 0;
+    camera.left = player_y - camera.width / 2;
+    if (camera.left > cols - camera.width) camera.left = cols - camera.width;
+    if (camera.left < 0) camera.left = 0;
+}
+
+void initialize_game(Arena **arena, int *rows, int *cols, int *player_x, int *player_y) {
     
     get_arena_dimensions(arena_files[current_arena], rows, cols);
     *arena = create_arena(*rows, *cols); 
     initialize_arena(*arena, *rows, *cols, arena_files[current_arena]);
 
-    for (int i = 0; i < *rows; i++) { // find the initial player position
-        for (int j = 0; j < *cols; j++) {
-            if ((*arena)[i][j] == 'p') {
-                *player_x = i;
-                *player_y = j;
-                return;
-            }
-        }
-    }
+    *player_x = (*arena)->start_row; // initial player position
+    *player_y = (*arena)->start_col;
 }
 
 void set_arena_files(char **files, int count) {
-    if (arena_files != NULL) free(arena_files);  // free old arena files if exist
+    if (arena_files != NULL) game_free(arena_files);  // free old arena files if exist
 
-    arena_files = (char **)malloc(count * sizeof(char *)); // allocate memory dynamically based on the count of files
+    arena_files = (char **)game_malloc(count * sizeof(char *)); // allocate memory dynamically based on the count of files
     for (int i = 0; i < count; i++) arena_files[i] = files[i];
     num_arenas = count;  // set the number of arenas
 }
 
+int arenas_cleared(int upto) { // the welcome screen & the tutorials aren't arenas of the run
+    int cleared = 0;
+    for (int i = 0; i < upto; i++) cleared += strstr(arena_files[i], "arena") || strstr(arena_files[i], "test");
+    return cleared;
+}
+
+/*
+    ARENA LAYERS
+*/
+void cellmap_init(CellMap *map, BumpAllocator *memory, uint64_t *hash) {
+    map->capacity = 16;
+    map->count = 0;
+    map->memory = memory;
+    map->hash = hash;
+    map->keys = (int *)bump_alloc(memory, map->capacity * sizeof(int));
+    map->values = (char *)bump_alloc(memory, map->capacity);
+    for (int i = 0; i < map->capacity; i++) map->keys[i] = -1;
+}
+
+static int cellmap_home(const CellMap *map, int cell) {
+    return (int)(((unsigned)cell * 2654435761u) & (map->capacity - 1));
+}
+
+static int cellmap_slot(const CellMap *map, int cell) { // slot holding the cell, or the empty slot where it would go
+    int slot = cellmap_home(map, cell);
+    while (map->keys[slot] != -1 && map->keys[slot] != cell) slot = (slot + 1) & (map->capacity - 1);
+    return slot;
+}
+
+char cellmap_get(const CellMap *map, int cell) {
+    if (!map->count) return '\0';
+    int slot = cellmap_slot(map, cell);
+    return map->keys[slot] == -1 ? '\0' : map->values[slot];
+}
+
+void cellmap_put(CellMap *map, int cell, char value) {
+    if (2 * (map->count + 1) > map->capacity) { // keep the load under 1/2
+        CellMap bigger = { NULL, NULL, map->capacity * 2, 0, map->memory, NULL }; // same entries ~ the hash stays as it is
+        bigger.keys = (int *)bump_alloc(map->memory, bigger.capacity * sizeof(int));
+        bigger.values = (char *)bump_alloc(map->memory, bigger.capacity);
+        for (int i = 0; i < bigger.capacity; i++) bigger.keys[i] = -1;
+        for (int i = 0; i < map->capacity; i++) if (map->keys[i] != -1) cellmap_put(&bigger, map->keys[i], map->values[i]);
+        bigger.hash = map->hash;
+        *map = bigger; // the old slots stay in the level memory until the level is freed
+    }
+
+    int slot = cellmap_slot(map, cell);
+    if (map->keys[slot] == -1) {
+        map->keys[slot] = cell;
+        map->count++;
+    }
+    else if (map->hash) *map->hash ^= state_key(cell, map->values[slot]);
+    if (map->hash) *map->hash ^= state_key(cell, value);
+    map->values[slot] = value;
+}
+
+void cellmap_remove(CellMap *map, int cell) {
+    if (!map->count) return;
+    int mask = map->capacity - 1;
+    int slot = cellmap_slot(map, cell);
+    if (map->keys[slot] == -1) return;
+
+    if (map->hash) *map->hash ^= state_key(cell, map->values[slot]);
+    map->keys[slot] = -1;
+    map->count--;
+    for (int next = (slot + 1) & mask; map->keys[next] != -1; next = (next + 1) & mask) { // shift back the rest of the probe run
+        if (((next - cellmap_home(map, map->keys[next])) & mask) >= ((next - slot) & mask)) {
+            map->keys[slot] = map->keys[next];
+            map->values[slot] = map->values[next];
+            map->keys[next] = -1;
+            slot = next;
+        }
+    }
+}
+
+void entity_grid_init(EntityGrid *grid, int rows, int cols, BumpAllocator *memory) {
+    int bucket_rows = (rows >> ENTITY_BUCKET_BITS) + 1;
+    grid->cols = cols;
+    grid->bucket_cols = (cols >> ENTITY_BUCKET_BITS) + 1;
+    grid->buckets = (int *)bump_alloc(memory, bucket_rows * grid->bucket_cols * sizeof(int));
+    for (int i = 0; i < bucket_rows * grid->bucket_cols; i++) grid->buckets[i] = -1;
+    grid->capacity = 16;
+    grid->entities = (Entity *)bump_alloc(memory, grid->capacity * sizeof(Entity));
+    for (int i = 0; i < grid->capacity; i++) grid->entities[i].next = i + 1 < grid->capacity ? i + 1 : -1;
+    grid->free = 0;
+    grid->memory = memory;
+}
+
+static int entity_bucket(const EntityGrid *grid, int cell) {
+    return ((cell / grid->cols) >> ENTITY_BUCKET_BITS) * grid->bucket_cols + ((cell % grid->cols) >> ENTITY_BUCKET_BITS);
+}
+
+static void entity_link(EntityGrid *grid, int id) {
+    int bucket = entity_bucket(grid, grid->entities[id].cell);
+    grid->entities[id].next = grid->buckets[bucket];
+    grid->buckets[bucket] = id;
+}
+
+static int entity_unlink(EntityGrid *grid, int cell) { // walks one bucket, at most 64 entities
+    int *link = &grid->buckets[entity_bucket(grid, cell)];
+    while (*link != -1 && grid->entities[*link].cell != cell) link = &grid->entities[*link].next;
+    int id = *link;
+    if (id != -1) *link = grid->entities[id].next;
+    return id;
+}
+
+void warrior_add(Arena *arena, int cell) {
+    EntityGrid *grid = &arena->warrior_grid;
+    if (cellmap_get(&arena->warriors, cell)) return;
+    cellmap_put(&arena->warriors, cell, 'w');
+
+    if (grid->free == -1) { // the ids stay the same, the old pool stays in the level memory until the level is freed
+        Entity *bigger = (Entity *)bump_alloc(grid->memory, 2 * grid->capacity * sizeof(Entity));
+        memcpy(bigger, grid->entities, grid->capacity * sizeof(Entity));
+        for (int i = grid->capacity; i < 2 * grid->capacity; i++) bigger[i].next = i + 1 < 2 * grid->capacity ? i + 1 : -1;
+        grid->free = grid->capacity;
+        grid->capacity *= 2;
+        grid->entities = bigger;
+    }
+
+    int id = grid->free;
+    grid->free = grid->entities[id].next;
+    grid->entities[id].cell = cell;
+    entity_link(grid, id);
+}
+
+void warrior_remove(Arena *arena, int cell) {
+    EntityGrid *grid = &arena->warrior_grid;
+    if (!cellmap_get(&arena->warriors, cell)) return;
+    cellmap_remove(&arena->warriors, cell);
+
+    int id = entity_unlink(grid, cell);
+    grid->entities[id].next = grid->free;
+    grid->free = id;
+}
+
+void warrior_move(Arena *arena, int from, int to) {
+    EntityGrid *grid = &arena->warrior_grid;
+    cellmap_remove(&arena->warriors, from);
+    cellmap_put(&arena->warriors, to, 'w');
+
+    int id = entity_unlink(grid, from);
+    grid->entities[id].cell = to;
+    entity_link(grid, id);
+}
+
+int warriors_near(Arena *arena, int row, int col, int radius, int *cells, int max) {
+    EntityGrid *grid = &arena->warrior_grid;
+    int count = 0;
+    int top = row - radius < 0 ? 0 : (row - radius) >> ENTITY_BUCKET_BITS;
+    int bottom = (row + radius >= arena->rows ? arena->rows - 1 : row + radius) >> ENTITY_BUCKET_BITS;
+    int left = col - radius < 0 ? 0 : (col - radius) >> ENTITY_BUCKET_BITS;
+    int right = (col + radius >= arena->cols ? arena->cols - 1 : col + radius) >> ENTITY_BUCKET_BITS;
+
+    for (int i = top; i <= bottom; i++) {
+        for (int j = left; j <= right; j++) { // only the buckets the circle overlaps
+            for (int id = grid->buckets[i * grid->bucket_cols + j]; id != -1 && count < max; id = grid->entities[id].next) {
+                int cell = grid->entities[id].cell;
+                int row_offset = cell / arena->cols - row, col_offset = cell % arena->cols - col;
+                if (row_offset * row_offset + col_offset * col_offset <= radius * radius) cells[count++] = cell;
+            }
+        }
+    }
+    return count;
+}
+
+int terrain_at(Arena *arena, int row, int col) {
+    unsigned char pair = arena->terrain[row * arena->stride + col / 2];
+    return col & 1 ? pair >> 4 : pair & 0x0F;
+}
+
+void set_terrain(Arena *arena, int row, int col, int tile) {
+    unsigned char *pair = &arena->terrain[row * arena->stride + col / 2];
+    int old = col & 1 ? *pair >> 4 : *pair & 0x0F;
+    if (old == tile) return;
+    arena->hash ^= terrain_key(row * arena->cols + col, old) ^ terrain_key(row * arena->cols + col, tile);
+    if (col & 1) *pair = (*pair & 0x0F) | (tile << 4);
+    else *pair = (*pair & 0xF0) | tile;
+    vision_invalidate(arena, row, col);
+
+    uint64_t *word = &arena->passable[row * arena->words + col / 64];
+    if (tile == TILE_EMPTY || tile == TILE_SMALL_HOLE) *word |= 1ull << (col % 64);
+    else *word &= ~(1ull << (col % 64));
+    arena->terrain_version++;
+}
+
+char arena_tile(Arena *arena, int row, int col) {
+    int cell = row * arena->cols + col;
+    char glyph;
+    int boss;
+    if (arena->boss_count && (boss = boss_at(arena, row, col)) != -1) return BOSS_SHAPES[arena->bosses[boss].shape].glyph;
+    if ((glyph = cellmap_get(&arena->warriors, cell))) return glyph;
+    if ((glyph = cellmap_get(&arena->items, cell))) return glyph;
+
+    int tile = terrain_at(arena, row, col);
+    return tile == TILE_LABEL ? cellmap_get(&arena->labels, cell) : TILE_GLYPHS[tile];
+}
+
+void arena_put(Arena *arena, int row, int col, char glyph) {
+    int cell = row * arena->cols + col;
+    const char *tile = glyph ? strchr(TILE_GLYPHS, glyph) : NULL;
+
+    warrior_remove(arena, cell);
+    cellmap_remove(&arena->items, cell);
+    cellmap_remove(&arena->labels, cell);
+    int code = TILE_EMPTY; // set once, so unchanged tiles keep the fields of view around them
+
+    if (glyph == 'p') { // the player is not part of the arena, only its starting point
+        arena->start_row = row;
+        arena->start_col = col;
+    }
+    else if (glyph == 'w') warrior_add(arena, cell);
+    else if (glyph == '&') boss_add(arena, 0, row, col); // the footprint starts here, the tiles under it stay what the file says
+    else if (glyph && strchr(ITEM_GLYPHS, glyph)) cellmap_put(&arena->items, cell, glyph);
+    else if (tile) code = tile - TILE_GLYPHS;
+    else {
+        code = TILE_LABEL;
+        cellmap_put(&arena->labels, cell, glyph);
+    }
+    set_terrain(arena, row, col, code);
+}
+
+void place_player(Arena *arena, int player_x, int player_y) {
+    if (!weapon_flag || !cellmap_get(&arena->warriors, player_x * arena->cols + player_y)) return; // unarmed, the rules already killed the player
+    warrior_remove(arena, player_x * arena->cols + player_y);
+    GAME_EVENT(EVENT_WARRIOR_KILL, 0);
+}
+
+int arena_snapshot_size(Arena *arena) {
+    int cells = arena->rows * arena->cols;
+    return cells + (cells + 7) / 8 + sizeof(arena->bosses);
+}
+
+void save_arena_snapshot(Arena *arena, char *snapshot) {
+    int cells = arena->rows * arena->cols;
+    memset(snapshot + cells, 0, (cells + 7) / 8);
+    for (int cell = 0; cell < cells; cell++) {
+        char item = cellmap_get(&arena->items, cell);
+        int tile = terrain_at(arena, cell / arena->cols, cell % arena->cols);
+        if (item) snapshot[cell] = item;
+        else snapshot[cell] = tile == TILE_LABEL ? cellmap_get(&arena->labels, cell) : TILE_GLYPHS[tile];
+        if (cellmap_get(&arena->warriors, cell)) snapshot[cells + cell / 8] |= 1 << (cell % 8);
+    }
+    memcpy(snapshot + cells + (cells + 7) / 8, arena->bosses, sizeof(arena->bosses));
+}
+
+void load_arena_snapshot(Arena *arena, const char *snapshot) {
+    int cells = arena->rows * arena->cols;
+    for (int cell = 0; cell < cells; cell++) {
+        arena_put(arena, cell / arena->cols, cell % arena->cols, snapshot[cell]);
+        if (snapshot[cells + cell / 8] & (1 << (cell % 8))) warrior_add(arena, cell);
+    }
+
+    arena->boss_count = 0;
+    memcpy(arena->bosses, snapshot + cells + (cells + 7) / 8, sizeof(arena->bosses));
+    while (arena->boss_count < MAX_BOSSES && arena->bosses[arena->boss_count].health) arena->boss_count++;
+}
+
+/*
+    TILE KERNELS (bulk scans over the packed terrain, picked at startup: avx2 > sse2 > scalar)
+*/
+static size_t count_tiles_scalar(const unsigned char *tiles, size_t bytes, int tile) {
+    size_t count = 0;
+    for (size_t i = 0; i < bytes; i++) count += ((tiles[i] & 0x0F) == tile) + ((tiles[i] >> 4) == tile);
+    return count;
+}
+
+static long find_tile_scalar(const unsigned char *tiles, size_t bytes, size_t from, int tile) {
+    for (size_t n = from; n < 2 * bytes; n++) if (((tiles[n / 2] >> (n & 1) * 4) & 0x0F) == tile) return n;
+    return -1;
+}
+
+static void replace_tiles_scalar(unsigned char *tiles, size_t bytes, int from, int to) {
+    for (size_t i = 0; i < bytes; i++) {
+        int low = tiles[i] & 0x0F, high = tiles[i] >> 4;
+        tiles[i] = (low == from ? to : low) | (high == from ? to : high) << 4;
+    }
+}
+
+#if TILE_KERNELS_X86
+__attribute__((target("sse2")))
+static size_t count_tiles_sse2(const unsigned char *tiles, size_t bytes, int tile) {
+    const __m128i nibble = _mm_set1_epi8(0x0F), wanted = _mm_set1_epi8(tile);
+    size_t count = 0, i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i pairs = _mm_loadu_si128((const __m128i *)(tiles + i));
+        __m128i low = _mm_and_si128(pairs, nibble), high = _mm_and_si128(_mm_srli_epi16(pairs, 4), nibble);
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(low, wanted)));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(high, wanted)));
+    }
+    return count + count_tiles_scalar(tiles + i, bytes - i, tile);
+}
+
+__attribute__((target("sse2")))
+static long find_tile_sse2(const unsigned char *tiles, size_t bytes, size_t from, int tile) {
+    const __m128i nibble = _mm_set1_epi8(0x0F), wanted = _mm_set1_epi8(tile);
+    size_t i = (from + 1) / 2; // whole bytes only, an odd start checks its high nibble first
+    if (from & 1 && from < 2 * bytes && (tiles[from / 2] >> 4) == tile) return from;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i pairs = _mm_loadu_si128((const __m128i *)(tiles + i));
+        int low = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(pairs, nibble), wanted));
+        int high = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(_mm_srli_epi16(pairs, 4), nibble), wanted));
+        if (low | high) {
+            int k = __builtin_ctz(low | high);
+            return 2 * (i + k) + !(low >> k & 1); // the low nibble comes first in reading order
+        }
+    }
+    return find_tile_scalar(tiles, bytes, 2 * i, tile);
+}
+
+__attribute__((target("sse2")))
+static void replace_tiles_sse2(unsigned char *tiles, size_t bytes, int from, int to) {
+    const __m128i nibble = _mm_set1_epi8(0x0F), wanted = _mm_set1_epi8(from);
+    const __m128i flip_low = _mm_set1_epi8(from ^ to), flip_high = _mm_set1_epi8((from ^ to) << 4);
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i pairs = _mm_loadu_si128((const __m128i *)(tiles + i));
+        __m128i low = _mm_cmpeq_epi8(_mm_and_si128(pairs, nibble), wanted);
+        __m128i high = _mm_cmpeq_epi8(_mm_and_si128(_mm_srli_epi16(pairs, 4), nibble), wanted);
+        if (!_mm_movemask_epi8(_mm_or_si128(low, high))) continue; // nothing to write back
+        __m128i flip = _mm_or_si128(_mm_and_si128(low, flip_low), _mm_and_si128(high, flip_high));
+        _mm_storeu_si128((__m128i *)(tiles + i), _mm_xor_si128(pairs, flip));
+    }
+    replace_tiles_scalar(tiles + i, bytes - i, from, to);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t count_tiles_avx2(const unsigned char *tiles, size_t bytes, int tile) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F), wanted = _mm256_set1_epi8(tile);
+    size_t count = 0, i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i pairs = _mm256_loadu_si256((const __m256i *)(tiles + i));
+        __m256i low = _mm256_and_si256(pairs, nibble), high = _mm256_and_si256(_mm256_srli_epi16(pairs, 4), nibble);
+        count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, wanted)));
+        count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, wanted)));
+    }
+    return count + count_tiles_scalar(tiles + i, bytes - i, tile);
+}
+
+__attribute__((target("avx2")))
+static long find_tile_avx2(const unsigned char *tiles, size_t bytes, size_t from, int tile) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F), wanted = _mm256_set1_epi8(tile);
+    size_t i = (from + 1) / 2;
+    if (from & 1 && from < 2 * bytes && (tiles[from / 2] >> 4) == tile) return from;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i pairs = _mm256_loadu_si256((const __m256i *)(tiles + i));
+        unsigned low = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(pairs, nibble), wanted));
+        unsigned high = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(_mm256_srli_epi16(pairs, 4), nibble), wanted));
+        if (low | high) {
+            int k = __builtin_ctz(low | high);
+            return 2 * (i + k) + !(low >> k & 1);
+        }
+    }
+    return find_tile_scalar(tiles, bytes, 2 * i, tile);
+}
+
+__attribute__((target("avx2")))
+static void replace_tiles_avx2(unsigned char *tiles, size_t bytes, int from, int to) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F), wanted = _mm256_set1_epi8(from);
+    const __m256i flip_low = _mm256_set1_epi8(from ^ to), flip_high = _mm256_set1_epi8((from ^ to) << 4);
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i pairs = _mm256_loadu_si256((const __m256i *)(tiles + i));
+        __m256i low = _mm256_cmpeq_epi8(_mm256_and_si256(pairs, nibble), wanted);
+        __m256i high = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_srli_epi16(pairs, 4), nibble), wanted);
+        if (!_mm256_movemask_epi8(_mm256_or_si256(low, high))) continue;
+        __m256i flip = _mm256_or_si256(_mm256_and_si256(low, flip_low), _mm256_and_si256(high, flip_high));
+        _mm256_storeu_si256((__m256i *)(tiles + i), _mm256_xor_si256(pairs, flip));
+    }
+    replace_tiles_scalar(tiles + i, bytes - i, from, to);
+}
+#endif
+
+const TileKernels TILE_KERNELS[] = {
+    {"scalar", count_tiles_scalar, find_tile_scalar, replace_tiles_scalar},
+#if TILE_KERNELS_X86
+    {"sse2", count_tiles_sse2, find_tile_sse2, replace_tiles_sse2},
+    {"avx2", count_tiles_avx2, find_tile_avx2, replace_tiles_avx2},
+#endif
+};
+const int TILE_KERNEL_COUNT = sizeof(TILE_KERNELS) / sizeof(TILE_KERNELS[0]);
+
+int tile_kernels_supported(const TileKernels *kernels) {
+#if TILE_KERNELS_X86
+    __builtin_cpu_init();
+    if (!strcmp(kernels->name, "sse2")) return __builtin_cpu_supports("sse2");
+    if (!strcmp(kernels->name, "avx2")) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+    return 1;
+}
+
+void tile_kernels_init() { // the best supported set, TA_SIMD=scalar|sse2|avx2 caps it
+    const char *cap = getenv("TA_SIMD");
+    for (int i = 0; i < TILE_KERNEL_COUNT; i++) {
+        if (!tile_kernels_supported(&TILE_KERNELS[i])) break;
+        tile_kernels = TILE_KERNELS[i];
+        if (cap && !strcmp(cap, TILE_KERNELS[i].name)) break;
+    }
+}
+
+long count_terrain(Arena *arena, int tile) { // the padding nibble of odd widths counts as TILE_EMPTY
+    return tile_kernels.count(arena->terrain, (size_t)arena->rows * arena->stride, tile);
+}
+
+int find_terrain(Arena *arena, int tile, long *from, int *row, int *col) {
+    long n = tile_kernels.find(arena->terrain, (size_t)arena->rows * arena->stride, *from, tile);
+    if (n < 0) return 0;
+    *from = n + 1;
+    *row = n / (2 * arena->stride);
+    *col = n % (2 * arena->stride);
+    return 1;
+}
+
+void replace_terrain(Arena *arena, int from, int to) {
+    long first = 0;
+    int row, col;
+    if (!find_terrain(arena, from, &first, &row, &col)) return; // nothing to replace, the fields of view stay valid
+    long next = first;
+    do { // only the replaced tiles change the hash
+        if (col < arena->cols) arena->hash ^= terrain_key(row * arena->cols + col, from) ^ terrain_key(row * arena->cols + col, to);
+    } while (find_terrain(arena, from, &next, &row, &col));
+    tile_kernels.replace(arena->terrain, (size_t)arena->rows * arena->stride, from, to);
+    vision_reset(arena); // doors open all over the arena at once
+    passability_rebuild(arena);
+}
+
 /*
     HANDLE FUNCTIONS
 */
-void print_gui(char **arena, int rows, int cols) {
+void print_gui(Arena *arena, int rows, int cols, int player_x, int player_y) {
     clear_console(); 
+    update_camera(rows, cols, player_x, player_y);
      
     if(!played_tutorial || (played_tutorial && current_arena >=7 )) {
         printf("= = = = = = = = = = = =\n|");
         handle_highscore_coins(score, coins);
     }
-    print_arena(arena, rows, cols);    
+    print_arena(arena, rows, cols, player_x, player_y);    
       
     if (played_tutorial) { 
         if (current_arena == 3) {  
@@ -615,35 +2011,15 @@ void handle_highscore_coins(int score, int coins) {
     }
 }
 
-void handle_tutorials() { 
-    char *arr = arena_files[current_arena];
-    char last_char = arr[strlen(arr)-5];
-            
-    if(strstr(arena_files[current_arena],"tutorial")){
-            
-        switch(last_char){
-            case '0': // tutorial about keys & doors
-                display_tutorial0();
-                break;
-            case '1': // tutorial about special keys and exit doors unlocking
-                display_tutorial1();
-                break;
-            case '2': // tutorial about spikes
-                display_tutorial2();
-                break;
-            case '3': // tutorial about health increase
-                display_tutorial3();
-                break;
-            case '4': // tutorial about holes
-                display_tutorial4();
-                break;
-            default: break;
-        }
-    }
+void handle_triggers(Arena *arena) { 
+    if (arena->trigger_screen == -1) return;
+    display_trigger_screen(arena->trigger_screen);
+    arena->trigger_screen = -1;
 }
 
-int process_player_inputs(int *player_x, int *player_y, char **arena, int rows, int cols) {
+int process_player_inputs(int *player_x, int *player_y, Arena *arena, int rows, int cols) {
     char input = getchar();
+    GAME_EVENT(EVENT_INPUT, input);
 
     if (input == '\t') { // if tab is pressed
         is_paused = true;
@@ -651,6 +2027,11 @@ int process_player_inputs(int *player_x, int *player_y, char **arena, int rows,
         if (pause) return 1; // if the user chooses to exit the game
         else block_input = 1; // block input in case he returns to the game
     }
+    else if (input == 'p' || input == 'P') { // profiler on / off
+        profile_toggle();
+        block_input = 1;
+        return 0;
+    }
     else if (input == '\x1b') {  // handling arrow keys
         input = getchar();
         if(input =='['){
@@ -661,42 +2042,59 @@ int process_player_inputs(int *player_x, int *player_y, char **arena, int rows,
             }
         }
     }
-  
+
+    move_player(input, player_x, player_y, arena, rows, cols);
+    
+    return 0; 
+}
+
+void move_player(char input, int *player_x, int *player_y, Arena *arena, int rows, int cols) {
     switch (input) {
         case 'w': case 'W': // move up
-            if (*player_x > 1 && arena[*player_x - 1][*player_y] != '=' && arena[*player_x - 1][*player_y] != '|' && arena[*player_x - 1][*player_y] != 'D' && arena[*player_x - 1][*player_y] != 'd') 
+            facing = 0;
+            if (*player_x > 1 && arena_tile(arena, *player_x - 1, *player_y) != '=' && arena_tile(arena, *player_x - 1, *player_y) != '|' && arena_tile(arena, *player_x - 1, *player_y) != 'D' && arena_tile(arena, *player_x - 1, *player_y) != 'd') 
                 (*player_x)--;
             break;
         case 's': case 'S': // move down
-            if (*player_x < rows - 2 && arena[*player_x + 1][*player_y] != '=' && arena[*player_x + 1][*player_y] != '|' && arena[*player_x + 1][*player_y] != 'D' && arena[*player_x + 1][*player_y] != 'd') 
+            facing = 1;
+            if (*player_x < rows - 2 && arena_tile(arena, *player_x + 1, *player_y) != '=' && arena_tile(arena, *player_x + 1, *player_y) != '|' && arena_tile(arena, *player_x + 1, *player_y) != 'D' && arena_tile(arena, *player_x + 1, *player_y) != 'd') 
                 (*player_x)++;
             break;
         case 'a': case 'A': // move left
-            if (*player_y > 1 && arena[*player_x][*player_y - 1] != '=' && arena[*player_x][*player_y - 1] != '|' && arena[*player_x][*player_y - 1] != 'D' && arena[*player_x][*player_y - 1] != 'd') 
+            facing = 2;
+            if (*player_y > 1 && arena_tile(arena, *player_x, *player_y - 1) != '=' && arena_tile(arena, *player_x, *player_y - 1) != '|' && arena_tile(arena, *player_x, *player_y - 1) != 'D' && arena_tile(arena, *player_x, *player_y - 1) != 'd') 
                 (*player_y)--;
             break;
         case 'd': case 'D': // move right
-            if (*player_y < cols - 2 && arena[*player_x][*player_y + 1] != '=' && arena[*player_x][*player_y + 1] != '|' && arena[*player_x][*player_y + 1] != 'D' && arena[*player_x][*player_y + 1] != 'd') 
+            facing = 3;
+            if (*player_y < cols - 2 && arena_tile(arena, *player_x, *player_y + 1) != '=' && arena_tile(arena, *player_x, *player_y + 1) != '|' && arena_tile(arena, *player_x, *player_y + 1) != 'D' && arena_tile(arena, *player_x, *player_y + 1) != 'd') 
                 (*player_y)++;
             break;
         case '1': // inventory slot 1
-            handle_inventory_slot(&items[0]);
+            handle_inventory_slot(arena, &items[0]);
             block_input = 1;
             break;
         case '2': // inventory slot 2
-            handle_inventory_slot(&items[1]);
+            handle_inventory_slot(arena, &items[1]);
             block_input = 1;
             break;
         case '3': // inventory slot 3
-            handle_inventory_slot(&items[2]);
+            handle_inventory_slot(arena, &items[2]);
             block_input = 1;
             break;
+        case 'b': case 'B': // build a wall in front of the player, takes a turn
+            if (!build_wall(arena, *player_x, *player_y)) block_input = 1;
+            break;
+        case 'z': case 'Z': // undo the last build
+            if (!journal_undo(arena)) block_input = 1;
+            break;
+        case 'y': case 'Y': // redo it
+            if (!journal_redo(arena)) block_input = 1;
+            break;
         default:
             block_input = 1;
             break;
     }
-    
-    return 0; 
 }
 
 int is_inventory_full(char items[]) { 
@@ -708,7 +2106,7 @@ int is_inventory_full(char items[]) {
     return 1; // inventory is full
 }
 
-void handle_inventory_slot(char *item_slot) {
+void handle_inventory_slot(Arena *arena, char *item_slot) {
     if(*item_slot == '+') {
         player_h += 15;
         if (player_h > MAX_HEATH) player_h = 115;
@@ -716,226 +2114,4583 @@ void handle_inventory_slot(char *item_slot) {
     }
     else if(*item_slot == '^') {
         weapon_flag = 1;
+        arena_schedule(arena, TIMER_WEAPON, WEAPON_TICKS); // a second weapon restarts the buff
         *item_slot = '\0';
     }
     else if(*item_slot == ')') {
         weapon_flag = 1;
+        arena_schedule(arena, TIMER_WEAPON, WEAPON_TICKS);
         *item_slot = '\0';
     }
 }
 
-void handle_arena_exit(char **arena, int rows, int cols) {
-    for (int i = 0; i < rows; i++) { 
-        for (int j = 0; j < cols; j++) if (arena[i][j] == 'K' || arena[i][j] == 'w') exit_arena++; 
-    }
+void handle_arena_exit(Arena *arena) {
+    if (small_arena_exit(arena)) return;
+    exit_arena += arena->warriors.count + arena->boss_count;
+    for (int i = 0; i < arena->items.capacity; i++) if (arena->items.keys[i] != -1 && arena->items.values[i] == 'K') exit_arena++;
 
-    if (!exit_arena) {
-        for (int i = 0; i < rows; i++) { // change 'D' to '#' 
-            for (int j = 0; j < cols; j++)  if (arena[i][j] == 'D') arena[i][j] = '#';
-        }
+    if (!exit_arena) replace_terrain(arena, TILE_EXIT_DOOR, TILE_EXIT); // change 'D' to '#' 
+}
+
+void handle_consumable(char consumable, int player_x, int player_y, Arena *arena) {
+    if (cellmap_get(&arena->items, player_x * arena->cols + player_y) == consumable) {
+        if (!is_inventory_full(items)) { // if the inventory is not full, add the item
+            for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) {
+                if (items[i] == '\0') {
+                    items[i] = consumable;
+                    GAME_EVENT(EVENT_PICKUP, consumable);
+                    break;
+                }
+            }
+            cellmap_remove(&arena->items, player_x * arena->cols + player_y);
+        } // inventory is full ~ the item stays on the ground
+    }
+}
+
+TickResult apply_game_rules(Arena *arena, int *player_x, int *player_y) {
+    TickResult result = TICK_CONTINUE;
+    int tile = terrain_at(arena, *player_x, *player_y);
+    char item = cellmap_get(&arena->items, *player_x * arena->cols + *player_y);
+
+    int spike = tile == TILE_SPIKE || (tile == TILE_TIMED_SPIKE && arena->spikes_raised);
+    if (spike && !block_input) player_h -= 30; // -30 health if the player is on top of a spike
+
+    int boss = arena->boss_count ? boss_at(arena, *player_x, *player_y) : -1;
+    if (boss != -1 && weapon_flag && !block_input) boss_hit(arena, boss);
+
+    if ((cellmap_get(&arena->warriors, *player_x * arena->cols + *player_y) || boss != -1 || death_flag) && !weapon_flag) { // if player position = w position & the player has no weapon,
+        player_h -= 200;                                                                                // he dies, oth the warrior dies
+        death_flag = 1;                                                
+    }
+
+    if (player_h <= 0) return spike ? TICK_SPIKE_DEATH : TICK_WARRIOR_DEATH; // health reaches 0 ~ death
+    if (tile == TILE_HOLE) return TICK_HOLE_DEATH; // fall in hole ~ instant death
+
+    if (tile == TILE_SMALL_HOLE) { // touching a small hole ~ lose all your items
+        for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
+    }
+    
+    handle_consumable('+', *player_x, *player_y, arena);
+    handle_consumable('^', *player_x, *player_y, arena);
+    handle_consumable(')', *player_x, *player_y, arena); 
+
+    if (item == 'k' || item == 'K') {
+        GAME_EVENT(EVENT_PICKUP, item);
+        cellmap_remove(&arena->items, *player_x * arena->cols + *player_y);
+        if (arena->timer_of[TIMER_DOORS] == -1) arena_schedule(arena, TIMER_DOORS, DOOR_DELAY); // change 'd' to ' ' a bit after the key is picked
+    }
+
+    if (item == 'c') {
+        GAME_EVENT(EVENT_PICKUP, item);
+        cellmap_remove(&arena->items, *player_x * arena->cols + *player_y);
+        coins++; score += 50; 
+    }
+
+    if (tile == TILE_LEFT_TELEPORTER || tile == TILE_RIGHT_TELEPORTER) { // jump to the last partner teleporter of the arena
+        int partner = tile == TILE_LEFT_TELEPORTER ? TILE_RIGHT_TELEPORTER : TILE_LEFT_TELEPORTER;
+        long from = 0;
+        int row, col;
+        while (find_terrain(arena, partner, &from, &row, &col)) {
+            *player_x = row;
+            *player_y = col;
+        }
+    }
+
+    if (triggers_step(arena, *player_x, *player_y)) result = TICK_INFO; // the screen is shown by the caller
+
+    if (!block_input) arena_tick(arena, *player_x, *player_y); // warriors, spikes, buffs & doors
+
+    if (terrain_at(arena, *player_x, *player_y) == TILE_EXIT) result = TICK_ARENA_EXIT; // the caller loads the next arena
+
+    return result;
+}
+
+TickResult simulate_tick(Arena *arena, int rows, int cols, int *player_x, int *player_y, char input) {
+    exit_arena = 0;
+    handle_arena_exit(arena);
+
+    block_input = 0;
+    if (!death_flag) move_player(input, player_x, player_y, arena, rows, cols);
+
+    TickResult result = apply_game_rules(arena, player_x, player_y);
+    if (result == TICK_CONTINUE || result == TICK_INFO) place_player(arena, *player_x, *player_y);
+    return result;
+}
+
+/*
+    TRIGGERS (regions of an arena that react to the player, from <arena>.triggers)
+*/
+static const char *TRIGGER_EVENT_NAMES[TRIGGER_EVENT_COUNT] = {"enter", "exit", "stay"};
+static const char *TRIGGER_ACTION_NAMES[TRIGGER_ACTION_COUNT] = {"screen", "score", "coins", "health", "buy"};
+
+static int trigger_name(const char *name, const char **names, int count) {
+    for (int i = 0; i < count; i++) if (!strcmp(name, names[i])) return i;
+    return -1;
+}
+
+static int trigger_parse(const char *line, int rows, int cols, Trigger *trigger, TriggerRegion *region) { // 0 = not a valid trigger
+    char event[16], action[16], argument[32];
+    int price = 0;
+    int fields = sscanf(line, "%15s %d %d %d %d %15s %31s %d", event, &region->top, &region->left, &region->bottom, &region->right, action, argument, &price);
+    if (fields < 7) return 0;
+    int e = trigger_name(event, TRIGGER_EVENT_NAMES, TRIGGER_EVENT_COUNT);
+    int a = trigger_name(action, TRIGGER_ACTION_NAMES, TRIGGER_ACTION_COUNT);
+    if (e == -1 || a == -1) return 0;
+    if (region->top < 0 || region->left < 0 || region->bottom >= rows || region->right >= cols || region->top > region->bottom || region->left > region->right) return 0;
+
+    trigger->event = e;
+    trigger->action = a;
+    trigger->item = '\0';
+    if (a == TRIGGER_SCREEN) trigger->value = trigger_screen(argument);
+    else if (a == TRIGGER_BUY) {
+        if (fields != 8 || strlen(argument) != 1 || !strchr("+^)", argument[0]) || price < 0) return 0;
+        trigger->item = argument[0];
+        trigger->value = price;
+    }
+    else trigger->value = atoi(argument);
+    return trigger->value != -1 || a != TRIGGER_SCREEN;
+}
+
+int triggers_path(const char *file_name, char *path) {
+    arena_path(file_name, path);
+    char *extension = strrchr(path, '.');
+    if (extension && !strchr(extension, '/')) *extension = '\0';
+    if (strlen(path) + sizeof(".triggers") > MAX_PATH_LENGTH) return 0;
+    strcat(path, ".triggers");
+    return 1;
+}
+
+void triggers_load(Arena *arena, const char *file_name) {
+    arena->region_of = NULL; // a reload drops the triggers loaded before, their memory goes with the level
+    arena->region_count = arena->trigger_count = 0;
+    char path[MAX_PATH_LENGTH];
+    if (!triggers_path(file_name, path)) return;
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return; // most arenas have none
+
+    Trigger parsed[MAX_TRIGGERS];
+    int region_of[MAX_TRIGGERS];
+    TriggerRegion regions[MAX_TRIGGER_REGIONS];
+    int count = 0, region_count = 0, number = 0;
+    char *line = NULL;
+    size_t capacity = 0;
+    while (getline(&line, &capacity, fp) != -1) { // event top left bottom right action argument [price]
+        number++;
+        if (line[strspn(line, " \t\r\n")] == '\0' || line[strspn(line, " \t")] == '#') continue;
+        TriggerRegion region;
+        if (count == MAX_TRIGGERS || !trigger_parse(line, arena->rows, arena->cols, &parsed[count], &region)) {
+            fprintf(stderr, "%s:%d: trigger ignored\n", path, number);
+            continue;
+        }
+        int r = 0;
+        while (r < region_count && (regions[r].top != region.top || regions[r].left != region.left || regions[r].bottom != region.bottom || regions[r].right != region.right)) r++;
+        if (r == MAX_TRIGGER_REGIONS) {
+            fprintf(stderr, "%s:%d: trigger ignored\n", path, number);
+            continue;
+        }
+        if (r == region_count) {
+            region.count = 0;
+            regions[region_count++] = region;
+        }
+        regions[r].count++;
+        region_of[count++] = r;
+    }
+    free(line);
+    fclose(fp);
+    if (!count) return;
+
+    arena->region_of = (unsigned char *)bump_alloc(&arena->memory, arena->rows * arena->cols);
+    memset(arena->region_of, 0, arena->rows * arena->cols);
+    arena->regions = (TriggerRegion *)bump_alloc(&arena->memory, region_count * sizeof(TriggerRegion));
+    arena->triggers = (Trigger *)bump_alloc(&arena->memory, count * sizeof(Trigger));
+    arena->region_count = region_count;
+    arena->trigger_count = count;
+
+    for (int r = 0, first = 0; r < region_count; first += regions[r++].count) { // a cell belongs to the last region that covers it
+        arena->regions[r] = regions[r];
+        arena->regions[r].first = first;
+        arena->regions[r].count = 0;
+        for (int i = regions[r].top; i <= regions[r].bottom; i++) memset(&arena->region_of[i * arena->cols + regions[r].left], r + 1, regions[r].right - regions[r].left + 1);
+    }
+    for (int t = 0; t < count; t++) { // file order inside a region
+        TriggerRegion *region = &arena->regions[region_of[t]];
+        arena->triggers[region->first + region->count++] = parsed[t];
+    }
+}
+
+static void triggers_fire(Arena *arena, int region, int event) {
+    const TriggerRegion *r = &arena->regions[region];
+    for (int i = r->first; i < r->first + r->count; i++) {
+        const Trigger *trigger = &arena->triggers[i];
+        if (trigger->event != event) continue;
+        switch (trigger->action) {
+            case TRIGGER_SCREEN: arena->trigger_screen = trigger->value; break;
+            case TRIGGER_SCORE: score += trigger->value; break;
+            case TRIGGER_COINS: coins = coins + trigger->value > 0 ? coins + trigger->value : 0; break;
+            case TRIGGER_HEALTH: // heals up to the cap, hurts down to 1 health ~ a trigger never kills
+                player_h += trigger->value;
+                if (player_h > MAX_HEATH) player_h = MAX_HEATH;
+                if (player_h < 1) player_h = 1;
+                break;
+            case TRIGGER_BUY:
+                if (coins < trigger->value || is_inventory_full(items)) break;
+                for (int s = 0; s < MAX_INVENTORY_ITEMS; s++) {
+                    if (items[s] == '\0') {
+                        items[s] = trigger->item;
+                        break;
+                    }
+                }
+                coins -= trigger->value;
+                GAME_EVENT(EVENT_PICKUP, trigger->item);
+                break;
+        }
+    }
+}
+
+int triggers_step(Arena *arena, int player_x, int player_y) {
+    int cell = player_x * arena->cols + player_y;
+    if (!arena->region_of || cell == arena->trigger_cell) return 0; // one byte read per tick, however many triggers there are
+    int from = arena->region_of[arena->trigger_cell], to = arena->region_of[cell];
+    arena->trigger_cell = cell;
+    arena->trigger_screen = -1;
+
+    if (from && from == to) triggers_fire(arena, to - 1, TRIGGER_STAY);
+    else {
+        if (from) triggers_fire(arena, from - 1, TRIGGER_EXIT);
+        if (to) triggers_fire(arena, to - 1, TRIGGER_ENTER);
+    }
+    return arena->trigger_screen != -1;
+}
+
+/*
+    RESET FUNCTIONS
+*/
+void reset_current_arena(Arena **arena, int *rows, int *cols, int *player_x, int *player_y) {
+    player_h = 100;
+    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
+    coins = 0;
+    score = 0;
+
+    free_arena(*arena); 
+    initialize_game(arena, rows, cols, player_x, player_y);
+}
+
+void reset_flags(int *exit_game, int *death_flag, int *weapon_flag) {
+    *exit_game = 0;
+    *death_flag = 0;
+    *weapon_flag = 0;
+}
+
+/*
+    TIMERS (hierarchical timer wheel, one tick = one move of the player)
+*/
+void timers_init(TimerWheel *wheel, BumpAllocator *memory) {
+    wheel->now = 0;
+    for (int i = 0; i < TIMER_LEVELS * TIMER_SLOTS; i++) wheel->slots[i] = -1;
+    wheel->timers = (Timer *)bump_alloc(memory, TIMER_POOL_SIZE * sizeof(Timer));
+    for (int i = 0; i < TIMER_POOL_SIZE; i++) {
+        wheel->timers[i].slot = -1;
+        wheel->timers[i].next = i + 1 < TIMER_POOL_SIZE ? i + 1 : -1;
+    }
+    wheel->free = 0;
+}
+
+static void timer_link(TimerWheel *wheel, int id) { // level = how far ahead, slot = those bits of the expiry tick
+    Timer *timer = &wheel->timers[id];
+    uint32_t delta = timer->expires - wheel->now;
+    int level = 0;
+    while (level < TIMER_LEVELS - 1 && delta >> (TIMER_SLOT_BITS * (level + 1))) level++;
+
+    timer->slot = level * TIMER_SLOTS + ((timer->expires >> (TIMER_SLOT_BITS * level)) & (TIMER_SLOTS - 1));
+    timer->prev = -1;
+    timer->next = wheel->slots[timer->slot];
+    if (timer->next != -1) wheel->timers[timer->next].prev = id;
+    wheel->slots[timer->slot] = id;
+}
+
+static void timer_unlink(TimerWheel *wheel, int id) {
+    Timer *timer = &wheel->timers[id];
+    if (timer->prev != -1) wheel->timers[timer->prev].next = timer->next;
+    else wheel->slots[timer->slot] = timer->next;
+    if (timer->next != -1) wheel->timers[timer->next].prev = timer->prev;
+    timer->slot = -1;
+}
+
+int timer_schedule(TimerWheel *wheel, int delay, int kind, int data) {
+    if (wheel->free == -1) return -1;
+    uint32_t limit = (1u << (TIMER_SLOT_BITS * TIMER_LEVELS)) - 1;
+    if (delay < 1) delay = 1; // the current tick is already being fired
+    if ((uint32_t)delay > limit) delay = limit;
+
+    int id = wheel->free;
+    Timer *timer = &wheel->timers[id];
+    wheel->free = timer->next;
+    timer->expires = wheel->now + delay;
+    timer->kind = kind;
+    timer->data = data;
+    timer_link(wheel, id);
+    return id;
+}
+
+void timer_cancel(TimerWheel *wheel, int id) {
+    if (id < 0 || wheel->timers[id].slot == -1) return;
+    timer_unlink(wheel, id);
+    wheel->timers[id].next = wheel->free;
+    wheel->free = id;
+}
+
+int timer_remaining(TimerWheel *wheel, int id) {
+    if (id < 0 || wheel->timers[id].slot == -1) return 0;
+    return (int)(wheel->timers[id].expires - wheel->now);
+}
+
+void timers_tick(TimerWheel *wheel) {
+    wheel->now++;
+    for (int level = 1; level < TIMER_LEVELS; level++) { // a lower level wrapped around ~ spread the next slot of this one below
+        if (wheel->now & ((1u << (TIMER_SLOT_BITS * level)) - 1)) break;
+
+        int slot = level * TIMER_SLOTS + ((wheel->now >> (TIMER_SLOT_BITS * level)) & (TIMER_SLOTS - 1));
+        int id = wheel->slots[slot];
+        wheel->slots[slot] = -1;
+        while (id != -1) {
+            int next = wheel->timers[id].next;
+            timer_link(wheel, id);
+            id = next;
+        }
+    }
+}
+
+int timer_pop_due(TimerWheel *wheel, Timer *timer) {
+    int id = wheel->slots[wheel->now & (TIMER_SLOTS - 1)];
+    if (id == -1) return 0;
+
+    *timer = wheel->timers[id];
+    timer_cancel(wheel, id); // freed first, so the owner can set it again right away
+    return 1;
+}
+
+void arena_schedule(Arena *arena, int kind, int delay) {
+    arena_cancel(arena, kind);
+    arena->timer_of[kind] = timer_schedule(&arena->timers, delay, kind, 0);
+}
+
+void arena_cancel(Arena *arena, int kind) {
+    timer_cancel(&arena->timers, arena->timer_of[kind]);
+    arena->timer_of[kind] = -1;
+}
+
+void arena_tick(Arena *arena, int player_x, int player_y) {
+    Timer timer;
+    timers_tick(&arena->timers);
+
+    while (timer_pop_due(&arena->timers, &timer)) {
+        arena->timer_of[timer.kind] = -1;
+
+        if (timer.kind == TIMER_FIGHTERS) {
+            ProfileScope start = PROFILE_BEGIN();
+            move_fighters(arena, arena->rows, arena->cols, player_x, player_y);
+            PROFILE_END(PHASE_FIGHTERS, start);
+            if (arena->warriors.count) arena_schedule(arena, TIMER_FIGHTERS, WARRIOR_CADENCE);
+        }
+        else if (timer.kind == TIMER_SPIKES) {
+            arena->spikes_raised = !arena->spikes_raised;
+            arena_schedule(arena, TIMER_SPIKES, SPIKE_TICKS);
+        }
+        else if (timer.kind == TIMER_WEAPON) weapon_flag = 0;
+        else if (timer.kind == TIMER_DOORS) replace_terrain(arena, TILE_DOOR, TILE_EMPTY);
+        else if (timer.kind == TIMER_BOSSES) {
+            move_bosses(arena, player_x, player_y);
+            if (arena->boss_count) arena_schedule(arena, TIMER_BOSSES, BOSS_CADENCE);
+        }
+    }
+}
+
+/*
+    VISION (recursive shadowcasting, a warrior only hunts the player it can see)
+*/
+static const int OCTANTS[8][4] = { // how (depth, offset) of every octant maps to (row, col) offsets
+    {-1, 0, 0, 1}, {0, -1, 1, 0}, {0, -1, -1, 0}, {-1, 0, 0, -1},
+    {1, 0, 0, -1}, {0, 1, -1, 0}, {0, 1, 1, 0}, {1, 0, 0, 1}
+};
+
+static int blocks_sight(Arena *arena, int row, int col) {
+    if (row < 0 || row >= arena->rows || col < 0 || col >= arena->cols) return 1;
+    int tile = terrain_at(arena, row, col);
+    return tile == TILE_WALL || tile == TILE_SIDE_WALL || tile == TILE_LABEL || tile == TILE_DOOR || tile == TILE_EXIT_DOOR;
+}
+
+static int vision_bit(int row_offset, int col_offset) {
+    return (row_offset + WARRIOR_VISION) * VISION_SIDE + col_offset + WARRIOR_VISION;
+}
+
+static int vision_slot(int cell) {
+    return (int)(((unsigned)cell * 2654435761u) & (VISION_CACHE_SIZE - 1));
+}
+
+static void cast_light(Arena *arena, VisionEntry *entry, int row, int col, const int *octant, int depth, double start, double end) {
+    if (start < end) return;
+    double next_start = start;
+
+    for (int d = depth; d <= WARRIOR_VISION && start >= end; d++) { // rows of the octant, moving away from the warrior
+        int blocked = 0;
+        for (int o = -d; o <= 0; o++) {
+            double left = (o - 0.5) / (-d + 0.5), right = (o + 0.5) / (-d - 0.5); // slopes of the tile edges
+            if (start < right) continue;
+            if (end > left) break;
+
+            int row_offset = d * octant[0] + o * octant[1], col_offset = d * octant[2] + o * octant[3];
+            if (d * d + o * o <= WARRIOR_VISION * WARRIOR_VISION) {
+                int bit = vision_bit(row_offset, col_offset);
+                entry->bits[bit / 64] |= 1ull << (bit % 64);
+            }
+
+            int wall = blocks_sight(arena, row + row_offset, col + col_offset);
+            if (blocked) {
+                if (wall) next_start = right;
+                else {
+                    blocked = 0;
+                    start = next_start;
+                }
+            }
+            else if (wall && d < WARRIOR_VISION) { // scan what is left of the view past the wall, then go on after it
+                blocked = 1;
+                cast_light(arena, entry, row, col, octant, d + 1, start, left);
+                next_start = right;
+            }
+        }
+        if (blocked) break;
+    }
+}
+
+static VisionEntry *warrior_vision(Arena *arena, int cell) {
+    VisionEntry *entry = &arena->vision[vision_slot(cell)];
+    if (entry->cell == cell) return entry;
+
+    if (entry->cell == -1) arena->vision_count++;
+    entry->cell = cell;
+    memset(entry->bits, 0, sizeof(entry->bits));
+    int bit = vision_bit(0, 0);
+    entry->bits[bit / 64] |= 1ull << (bit % 64);
+    for (int i = 0; i < 8; i++) cast_light(arena, entry, cell / arena->cols, cell % arena->cols, OCTANTS[i], 1, 1.0, 0.0);
+
+    PROFILE_COUNT(COUNTER_VISION_CASTS, 1);
+    return entry;
+}
+
+int warrior_sees(Arena *arena, int cell, int player_x, int player_y) {
+    int row_offset = player_x - cell / arena->cols, col_offset = player_y - cell % arena->cols;
+    if (row_offset * row_offset + col_offset * col_offset > WARRIOR_VISION * WARRIOR_VISION) return 0; // too far, no need to look
+
+    VisionEntry *entry = warrior_vision(arena, cell);
+    int bit = vision_bit(row_offset, col_offset);
+    return (entry->bits[bit / 64] >> (bit % 64)) & 1;
+}
+
+void vision_invalidate(Arena *arena, int row, int col) {
+    if (!arena->vision_count) return;
+
+    for (int i = row - WARRIOR_VISION; i <= row + WARRIOR_VISION; i++) {
+        for (int j = col - WARRIOR_VISION; j <= col + WARRIOR_VISION; j++) {
+            if (i < 0 || i >= arena->rows || j < 0 || j >= arena->cols) continue;
+
+            VisionEntry *entry = &arena->vision[vision_slot(i * arena->cols + j)];
+            if (entry->cell == i * arena->cols + j) {
+                entry->cell = -1;
+                arena->vision_count--;
+            }
+        }
+    }
+}
+
+void vision_reset(Arena *arena) {
+    for (int i = 0; i < VISION_CACHE_SIZE; i++) arena->vision[i].cell = -1;
+    arena->vision_count = 0;
+}
+
+/*
+    PATH FINDING
+*/
+void fighters_bfs(Arena *arena, int rows, int cols, int player_x, int player_y, const int *goals, int goal_count) {
+    int (*dist)[cols] = (int (*)[cols])arena->dist;
+    int *queue = arena->bfs_queue;
+    int head = 0, tail = 0;
+
+    for (int i = 0; i < arena->bfs_visited; i++) arena->dist[queue[i]] = -1; // -1 = not visited, only the last search has to be undone
+
+    int remaining = goal_count;
+    for (int i = 0; i < goal_count; i++) arena->dist[goals[i]] = -2; // -2 = goal not reached yet
+
+    queue[tail++] = player_x * cols + player_y;
+    if (dist[player_x][player_y] == -2) remaining--;
+    dist[player_x][player_y] = 0;
+
+    while (head < tail && (!goal_count || remaining)) { // bfs, every cell closer than the last goal already has its distance
+        int row = queue[head] / cols, col = queue[head] % cols;
+        head++;
+
+        for (int i = 0; i < 4; i++) {  // explore the 4 directions
+            int new_row = row + row_dir[i];
+            int new_col = col + col_dir[i];
+
+            if (new_row < 0 || new_row >= rows || new_col < 0 || new_col >= cols) continue;
+            int tile = terrain_at(arena, new_row, new_col);
+
+            // check if new position is within bounds, walkable, and not visited
+            if (tile != TILE_SIDE_WALL && tile != TILE_WALL && tile != TILE_SPIKE && tile != TILE_TIMED_SPIKE && tile != TILE_HOLE &&
+                tile != TILE_EXIT_DOOR && tile != TILE_DOOR && tile != TILE_EXIT && dist[new_row][new_col] < 0) {
+
+                if (dist[new_row][new_col] == -2) remaining--;
+                queue[tail++] = new_row * cols + new_col;
+                dist[new_row][new_col] = dist[row][col] + 1;  // increment dist
+            }
+        }
+    }
+
+    for (int i = 0; i < goal_count; i++) if (arena->dist[goals[i]] == -2) arena->dist[goals[i]] = -1; // goals the player can't reach
+    arena->bfs_visited = tail;
+    PROFILE_COUNT(COUNTER_BFS_NODES, head);
+}
+
+static int compare_cells(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+static int hunting_fighters(Arena *arena, int player_x, int player_y, int *fighters) { // warriors that see the player in reading order
+    int near[VISION_SIDE * VISION_SIDE]; // only warriors in vision range can see the player, the rest of the map is never visited
+    int count = 0;
+    int nearby = warriors_near(arena, player_x, player_y, WARRIOR_VISION, near, VISION_SIDE * VISION_SIDE);
+    for (int i = 0; i < nearby; i++) { // warriors that can't see the player stay where they are
+        if (warrior_sees(arena, near[i], player_x, player_y)) fighters[count++] = near[i];
+    }
+    qsort(fighters, count, sizeof(int), compare_cells);
+    return count;
+}
+
+void move_fighters(Arena *arena, int rows, int cols, int player_x, int player_y) {
+    if (small_move_fighters(arena, player_x, player_y)) return;
+    int (*dist)[cols] = (int (*)[cols])arena->dist;
+
+    int fighters[VISION_SIDE * VISION_SIDE];
+    int targets[VISION_SIDE * VISION_SIDE];
+    int count = hunting_fighters(arena, player_x, player_y, fighters);
+    if (!count) return; // nobody is hunting, no path finding at all
+
+    fighters_bfs(arena, rows, cols, player_x, player_y, fighters, count); // calculate distances from the player for each warrior
+
+    int moves = 0;
+
+    for (int k = 0; k < count; k++) { // calculate where 'w' go, every warrior sees the arena as it was before this turn
+        int i = fighters[k] / cols, j = fighters[k] % cols;
+        int min_dist = dist[i][j];
+        int next_row = i, next_col = j;
+        int found_better_move = 0;
+
+        for (int d = 0; d < 4; d++) { // check all 4 possible directions
+            int new_row = i + row_dir[d];
+            int new_col = j + col_dir[d];
+
+            if (new_row >= 0 && new_row < rows && new_col >= 0 && new_col < cols &&
+                dist[new_row][new_col] >= 0 && dist[new_row][new_col] < min_dist) {
+                char tile = arena_tile(arena, new_row, new_col);
+                if (tile == ' ' || tile == 'o' || tile == '+' || tile == '^' || (new_row == player_x && new_col == player_y)) { // the player's cell, whatever it shows
+                    min_dist = dist[new_row][new_col];
+                    next_row = new_row;
+                    next_col = new_col;
+                    found_better_move = 1;
+                }
+            }
+        }
+
+        if (found_better_move) {
+            if (next_row == player_x && next_col == player_y && !weapon_flag) {
+                death_flag = 1;
+                return; // stops next to the player, nobody moves this turn
+            }
+            fighters[moves] = fighters[k];
+            targets[moves++] = next_row * cols + next_col;
+            dist[next_row][next_col] = -3; // claimed, the warriors after this one go around it
+        }
+    }
+
+    for (int m = 0; m < moves; m++) warrior_move(arena, fighters[m], targets[m]); // targets were free before the turn, only an armed player is stepped on
+}
+
+/*
+    SMALL ARENAS (fixed-size copies of the path finding & exit scan, no bounds checks)
+*/
+#define SMALL_BLOCKED (1u << TILE_SIDE_WALL | 1u << TILE_WALL | 1u << TILE_SPIKE | 1u << TILE_TIMED_SPIKE | 1u << TILE_HOLE | \
+    1u << TILE_EXIT_DOOR | 1u << TILE_DOOR | 1u << TILE_EXIT) // what fighters_bfs doesn't walk through
+
+int small_arena_side(int rows, int cols) { // TA_SMALL=0 keeps every arena on the generic paths
+    const char *small = getenv("TA_SMALL");
+    if (small && !strcmp(small, "0")) return 0;
+    if (rows <= 16 && cols <= 16) return 16;
+    if (rows <= 32 && cols <= 32) return 32;
+    return 0;
+}
+
+static void small_grid_sync(Arena *arena, int side) { // the border and everything past the arena is a side wall, so no step leaves the grid
+    if (arena->grid_version == arena->terrain_version) return;
+    int stride = side + 2;
+    memset(arena->grid, TILE_SIDE_WALL, stride * stride);
+    for (int i = 0; i < arena->rows; i++) {
+        for (int j = 0; j < arena->cols; j++) arena->grid[(i + 1) * stride + j + 1] = terrain_at(arena, i, j);
+    }
+    arena->grid_version = arena->terrain_version;
+}
+
+// one neighbor of the bfs: blocked tiles are a bit of SMALL_BLOCKED, the border is blocked too
+#define SMALL_BFS_STEP(next) do { \
+    int n_ = (next); \
+    if (!((SMALL_BLOCKED >> grid[n_]) & 1) && dist[n_] < 0) { \
+        if (dist[n_] == -2) remaining--; \
+        queue[tail++] = n_; \
+        dist[n_] = step; \
+    } \
+} while (0)
+
+// one neighbor a warrior can step to, the same test as move_fighters (player_cell is always enterable)
+#define SMALL_MOVE_STEP(next) do { \
+    int n_ = (next); \
+    if (dist[n_] >= 0 && dist[n_] < min_dist) { \
+        char tile = arena_tile(arena, n_ / S - 1, n_ % S - 1); \
+        if (tile == ' ' || tile == 'o' || tile == '+' || tile == '^' || n_ == player_cell) { \
+            min_dist = dist[n_]; \
+            best = n_; \
+        } \
+    } \
+} while (0)
+
+// fighters_bfs, move_fighters and handle_arena_exit for arenas up to N x N, cells are (row + 1) * (N + 2) + col + 1
+#define DEFINE_SMALL_ARENA(N) \
+static void small_bfs_##N(Arena *arena, short *dist, int start, const short *goals, int goal_count) { \
+    enum { S = N + 2 }; \
+    const unsigned char *grid = arena->grid; \
+    short queue[N * N]; /* only arena cells are ever queued */ \
+    int head = 0, tail = 0, remaining = goal_count; \
+    memset(dist, 0xFF, S * S * sizeof(short)); \
+    for (int i = 0; i < goal_count; i++) dist[goals[i]] = -2; \
+    if (dist[start] == -2) remaining--; \
+    queue[tail++] = start; \
+    dist[start] = 0; \
+    while (head < tail && (!goal_count || remaining)) { \
+        int cell = queue[head++]; \
+        short step = dist[cell] + 1; \
+        SMALL_BFS_STEP(cell - S); \
+        SMALL_BFS_STEP(cell + S); \
+        SMALL_BFS_STEP(cell - 1); \
+        SMALL_BFS_STEP(cell + 1); \
+    } \
+    for (int i = 0; i < goal_count; i++) if (dist[goals[i]] == -2) dist[goals[i]] = -1; \
+    PROFILE_COUNT(COUNTER_BFS_NODES, head); \
+} \
+\
+static void move_fighters_##N(Arena *arena, int player_x, int player_y) { \
+    enum { S = N + 2 }; \
+    int cols = arena->cols; \
+    int fighters[VISION_SIDE * VISION_SIDE]; \
+    int targets[VISION_SIDE * VISION_SIDE]; \
+    short goals[VISION_SIDE * VISION_SIDE]; \
+    short dist[S * S]; \
+    int count = hunting_fighters(arena, player_x, player_y, fighters); \
+    if (!count) return; \
+    small_grid_sync(arena, N); \
+    for (int k = 0; k < count; k++) goals[k] = (fighters[k] / cols + 1) * S + fighters[k] % cols + 1; \
+    int player_cell = (player_x + 1) * S + player_y + 1; \
+    small_bfs_##N(arena, dist, player_cell, goals, count); \
+    int moves = 0; \
+    for (int k = 0; k < count; k++) { \
+        int min_dist = dist[goals[k]], best = goals[k]; \
+        SMALL_MOVE_STEP(goals[k] - S); \
+        SMALL_MOVE_STEP(goals[k] + S); \
+        SMALL_MOVE_STEP(goals[k] - 1); \
+        SMALL_MOVE_STEP(goals[k] + 1); \
+        if (best == player_cell && !weapon_flag) { \
+            death_flag = 1; \
+            return; \
+        } \
+        if (best != goals[k]) { \
+            fighters[moves] = fighters[k]; \
+            targets[moves++] = (best / S - 1) * cols + best % S - 1; \
+            dist[best] = -3; \
+        } \
+    } \
+    for (int m = 0; m < moves; m++) warrior_move(arena, fighters[m], targets[m]); \
+} \
+\
+static void arena_exit_##N(Arena *arena) { /* only the door decision reads exit_arena, so it isn't counted here */ \
+    small_grid_sync(arena, N); \
+    if (!memchr(arena->grid, TILE_EXIT_DOOR, (N + 2) * (N + 2))) return; /* open already, or no door at all */ \
+    if (exit_arena || arena->warriors.count || arena->boss_count) return; \
+    for (int i = 0; i < arena->items.capacity; i++) if (arena->items.keys[i] != -1 && arena->items.values[i] == 'K') return; \
+    replace_terrain(arena, TILE_EXIT_DOOR, TILE_EXIT); \
+}
+
+DEFINE_SMALL_ARENA(16)
+DEFINE_SMALL_ARENA(32)
+
+int small_move_fighters(Arena *arena, int player_x, int player_y) {
+    switch (arena->small) {
+        case 16: move_fighters_16(arena, player_x, player_y); return 1;
+        case 32: move_fighters_32(arena, player_x, player_y); return 1;
+    }
+    return 0;
+}
+
+int small_arena_exit(Arena *arena) {
+    switch (arena->small) {
+        case 16: arena_exit_16(arena); return 1;
+        case 32: arena_exit_32(arena); return 1;
+    }
+    return 0;
+}
+
+/*
+    BOSSES (multi-tile enemies, footprints are tested a row of bits at a time)
+*/
+void passability_rebuild(Arena *arena) {
+    for (int i = 0; i < arena->rows; i++) {
+        for (int j = 0; j < arena->cols; j++) {
+            uint64_t *word = &arena->passable[i * arena->words + j / 64];
+            int tile = terrain_at(arena, i, j);
+            if (tile == TILE_EMPTY || tile == TILE_SMALL_HOLE) *word |= 1ull << (j % 64);
+            else *word &= ~(1ull << (j % 64));
+        }
+    }
+    arena->terrain_version++;
+}
+
+static uint64_t passable_bits(Arena *arena, int row, int col) { // bit j = tile (row, col + j) is passable
+    const uint64_t *words = &arena->passable[row * arena->words];
+    int word = col / 64, shift = col % 64;
+    uint64_t bits = words[word] >> shift;
+    if (shift && word + 1 < arena->words) bits |= words[word + 1] << (64 - shift);
+    return bits;
+}
+
+int footprint_fits(Arena *arena, const uint64_t *frame, int height, int row, int col) {
+    if (row < 0 || col < 0 || row + height > arena->rows) return 0; // the right edge is handled by the bitmap
+    for (int i = 0; i < height; i++) if (frame[i] & ~passable_bits(arena, row + i, col)) return 0;
+    return 1;
+}
+
+static int footprints_overlap(const uint64_t *a, int a_row, int a_col, int a_height, const uint64_t *b, int b_row, int b_col, int b_height) {
+    for (int row = a_row > b_row ? a_row : b_row; row < a_row + a_height && row < b_row + b_height; row++) {
+        uint64_t left = a[row - a_row], right = b[row - b_row];
+        if (a_col >= b_col ? (left << (a_col - b_col)) & right : left & (right << (b_col - a_col))) return 1;
+    }
+    return 0;
+}
+
+int boss_at(Arena *arena, int row, int col) {
+    for (int i = 0; i < arena->boss_count; i++) {
+        const Boss *boss = &arena->bosses[i];
+        int r = row - boss->row, c = col - boss->col;
+        if (r >= 0 && r < BOSS_MAX_SIZE && c >= 0 && c < 64 && (BOSS_SHAPES[boss->shape].frames[boss->frame][r] >> c & 1)) return i;
+    }
+    return -1;
+}
+
+void boss_add(Arena *arena, int shape, int row, int col) {
+    if (arena->boss_count == MAX_BOSSES) return;
+    arena->bosses[arena->boss_count++] = (Boss){ shape, row, col, 0, BOSS_HEALTH };
+
+    if (arena->boss_paths == NULL) {
+        arena->boss_paths = (BossPaths *)bump_alloc(&arena->memory, BOSS_SHAPE_COUNT * sizeof(BossPaths));
+        for (int i = 0; i < BOSS_SHAPE_COUNT; i++) arena->boss_paths[i] = (BossPaths){ NULL, NULL, -1, -1 };
+        arena->boss_queue = (int *)bump_alloc(&arena->memory, arena->rows * arena->cols * sizeof(int));
+    }
+    BossPaths *paths = &arena->boss_paths[shape];
+    if (paths->fits == NULL) {
+        paths->fits = (uint64_t *)bump_alloc(&arena->memory, arena->rows * arena->words * sizeof(uint64_t));
+        paths->dist = (int *)bump_alloc(&arena->memory, arena->rows * arena->cols * sizeof(int));
+    }
+}
+
+void boss_remove(Arena *arena, int index) {
+    arena->bosses[index] = arena->bosses[--arena->boss_count];
+    memset(&arena->bosses[arena->boss_count], 0, sizeof(Boss));
+}
+
+void boss_hit(Arena *arena, int index) {
+    if (--arena->bosses[index].health) return;
+    boss_remove(arena, index);
+    GAME_EVENT(EVENT_BOSS_KILL, 0);
+}
+
+static void boss_paths_update(Arena *arena, int shape, int player_x, int player_y) { // cached until the terrain changes or the player moves
+    const BossShape *boss_shape = &BOSS_SHAPES[shape];
+    BossPaths *paths = &arena->boss_paths[shape];
+    int rows = arena->rows, cols = arena->cols, words = arena->words;
+    int target = player_x * cols + player_y;
+    if (paths->version == arena->terrain_version && paths->target == target) return;
+
+    uint64_t footprint[BOSS_MAX_SIZE] = {0}; // every frame at once, so any frame can be shown on the way
+    for (int f = 0; f < BOSS_FRAMES; f++) {
+        for (int i = 0; i < boss_shape->height; i++) footprint[i] |= boss_shape->frames[f][i];
+    }
+
+    if (paths->version != arena->terrain_version) { // grid inflated by the footprint: 64 anchors per word
+        for (int r = 0; r < rows; r++) {
+            for (int w = 0; w < words; w++) {
+                uint64_t fits = r + boss_shape->height <= rows ? ~0ull : 0;
+                for (int i = 0; i < boss_shape->height && fits; i++) {
+                    for (int j = 0; j < boss_shape->width; j++) if (footprint[i] >> j & 1) fits &= passable_bits(arena, r + i, w * 64 + j);
+                }
+                paths->fits[r * words + w] = fits;
+            }
+        }
+    }
+    paths->version = arena->terrain_version;
+    paths->target = target;
+
+    int *dist = paths->dist, *queue = arena->boss_queue;
+    int head = 0, tail = 0;
+    for (int i = 0; i < rows * cols; i++) dist[i] = -1;
+    for (int i = 0; i < boss_shape->height; i++) { // every anchor that puts the footprint on the player
+        for (int j = 0; j < boss_shape->width; j++) {
+            int r = player_x - i, c = player_y - j;
+            if (!(footprint[i] >> j & 1) || r < 0 || c < 0 || !(paths->fits[r * words + c / 64] >> (c % 64) & 1) || dist[r * cols + c] != -1) continue;
+            dist[r * cols + c] = 0;
+            queue[tail++] = r * cols + c;
+        }
+    }
+
+    while (head < tail) {
+        int row = queue[head] / cols, col = queue[head] % cols;
+        head++;
+        for (int d = 0; d < 4; d++) {
+            int r = row + row_dir[d], c = col + col_dir[d];
+            if (r < 0 || r >= rows || c < 0 || c >= cols || dist[r * cols + c] != -1 || !(paths->fits[r * words + c / 64] >> (c % 64) & 1)) continue;
+            dist[r * cols + c] = dist[row * cols + col] + 1;
+            queue[tail++] = r * cols + c;
+        }
+    }
+    PROFILE_COUNT(COUNTER_BFS_NODES, head);
+}
+
+void move_bosses(Arena *arena, int player_x, int player_y) {
+    for (int b = 0; b < arena->boss_count; b++) {
+        Boss *boss = &arena->bosses[b];
+        const BossShape *shape = &BOSS_SHAPES[boss->shape];
+        boss_paths_update(arena, boss->shape, player_x, player_y);
+        const int *dist = arena->boss_paths[boss->shape].dist;
+
+        int frame = (boss->frame + 1) % BOSS_FRAMES;
+        int best_row = boss->row, best_col = boss->col;
+        int best = dist[boss->row * arena->cols + boss->col];
+        for (int d = 0; d < 4; d++) { // the closest anchor the next frame fits on without running into another boss
+            int r = boss->row + row_dir[d], c = boss->col + col_dir[d];
+            if (r < 0 || r >= arena->rows || c < 0 || c >= arena->cols) continue;
+            int next = dist[r * arena->cols + c];
+            if (next == -1 || (best != -1 && next >= best) || !footprint_fits(arena, shape->frames[frame], shape->height, r, c)) continue;
+
+            int blocked = 0;
+            for (int o = 0; o < arena->boss_count && !blocked; o++) {
+                const Boss *other = &arena->bosses[o];
+                blocked = o != b && footprints_overlap(shape->frames[frame], r, c, shape->height,
+                    BOSS_SHAPES[other->shape].frames[other->frame], other->row, other->col, BOSS_SHAPES[other->shape].height);
+            }
+            if (blocked) continue;
+            best = next;
+            best_row = r;
+            best_col = c;
+        }
+
+        if (best_row != boss->row || best_col != boss->col || footprint_fits(arena, shape->frames[frame], shape->height, boss->row, boss->col)) {
+            boss->row = best_row;
+            boss->col = best_col;
+            boss->frame = frame;
+        }
+
+        for (int i = 0; i < shape->height; i++) { // warriors under the footprint are crushed
+            for (int j = 0; j < shape->width; j++) {
+                if (shape->frames[boss->frame][i] >> j & 1) warrior_remove(arena, (boss->row + i) * arena->cols + boss->col + j);
+            }
+        }
+
+        if (boss_at(arena, player_x, player_y) == b) {
+            int count = arena->boss_count;
+            if (!weapon_flag) death_flag = 1;
+            else boss_hit(arena, b);
+            if (arena->boss_count < count) b--; // the last boss took this slot and has not moved yet
+        }
+    }
+}
+
+/*
+    MEMORY (the game allocates only through these, TA_ALLOC_CHECK=1 fails on any allocation during a tick)
+*/
+static void count_allocation(size_t size) {
+    alloc_stats.allocs++;
+    alloc_stats.bytes += size;
+    PROFILE_COUNT(COUNTER_ALLOCS, 1);
+    PROFILE_COUNT(COUNTER_ALLOC_BYTES, size);
+}
+
+void *game_malloc(size_t size) {
+    count_allocation(size);
+    return allocator.malloc(size);
+}
+
+void *game_calloc(size_t count, size_t size) {
+    count_allocation(count * size);
+    return allocator.calloc(count, size);
+}
+
+void *game_realloc(void *ptr, size_t size) {
+    count_allocation(size);
+    return allocator.realloc(ptr, size);
+}
+
+void game_free(void *ptr) {
+    if (ptr) alloc_stats.frees++;
+    allocator.free(ptr);
+}
+
+static void tick_allocation(size_t size) {
+    fprintf(stderr, "\nallocation check failed: %zu bytes allocated during a gameplay tick\n", size);
+    exit(EXIT_FAILURE);
+}
+
+static void *checked_malloc(size_t size) {
+    if (alloc_guard) tick_allocation(size);
+    return malloc(size);
+}
+
+static void *checked_calloc(size_t count, size_t size) {
+    if (alloc_guard) tick_allocation(count * size);
+    return calloc(count, size);
+}
+
+static void *checked_realloc(void *ptr, size_t size) {
+    if (alloc_guard) tick_allocation(size);
+    return realloc(ptr, size);
+}
+
+void alloc_check_init() {
+    const char *env = getenv("TA_ALLOC_CHECK");
+    if (env == NULL || !*env || !strcmp(env, "0")) return;
+    allocator = (Allocator){ checked_malloc, checked_calloc, checked_realloc, free };
+}
+
+void bump_init(BumpAllocator *bump, size_t first_block) {
+    bump->blocks = NULL;
+    bump->next_block = first_block;
+}
+
+void *bump_alloc(BumpAllocator *bump, size_t size) {
+    size = (size + 15) & ~(size_t)15; // keeps every allocation 16 byte aligned
+    BumpBlock *block = bump->blocks;
+
+    if (block == NULL || block->size - block->used < size) { // start a new block, the rest of the old one is wasted
+        size_t block_size = size > bump->next_block ? size : bump->next_block;
+        block = (BumpBlock *)game_malloc(sizeof(BumpBlock) + block_size);
+        if (block == NULL) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        block->next = bump->blocks;
+        block->size = block_size;
+        block->used = 0;
+        bump->blocks = block;
+        bump->next_block = BUMP_BLOCK_SIZE;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+void bump_release(BumpAllocator *bump) {
+    BumpBlock *block = bump->blocks;
+    while (block) {
+        BumpBlock *next = block->next;
+        game_free(block);
+        block = next;
+    }
+    bump->blocks = NULL;
+}
+
+/*
+    PROFILER (TA_PROFILE=1 or the 'p' key, report written on exit)
+*/
+uint64_t monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+static FILE *write_stream(ssize_t (*write_fn)(void *cookie, const char *buf, size_t size)) { // a FILE whose writes go to write_fn, NULL where there are no cookie streams
+#ifdef __linux__
+    return fopencookie(NULL, "w", (cookie_io_functions_t){ NULL, write_fn, NULL, NULL });
+#else
+    errno = ENOTSUP;
+    return NULL;
+#endif
+}
+
+static ssize_t counted_write(void *cookie, const char *buf, size_t size) { // stdout replacement, counts what reaches the terminal
+    size_t done = 0;
+    while (done < size) {
+        ssize_t written = write(STDOUT_FILENO, buf + done, size - done);
+        if (written <= 0) return done ? (ssize_t)done : -1;
+        done += written;
+    }
+    PROFILE_COUNT(COUNTER_BYTES_WRITTEN, size);
+    return size;
+}
+
+void profiler_init() {
+    const char *env = getenv("TA_PROFILE");
+    if (env == NULL || !*env || !strcmp(env, "0")) return;
+    if (strcmp(env, "1")) profiler.report_path = env; // anything else is the report file
+    profile_toggle();
+}
+
+void profile_toggle() {
+    static int counting = 0;
+
+    profiler.enabled = !profiler.enabled;
+    if (!profiler.enabled) return;
+    if (!profiler.used) atexit(profiler_dump);
+    profiler.used = 1;
+
+    if (!counting) { // route stdout through counted_write, only paid for once profiling was asked for
+        FILE *counted = write_stream(counted_write);
+        if (counted == NULL) return; // the terminal bytes go uncounted
+        setvbuf(counted, NULL, isatty(STDOUT_FILENO) ? _IOLBF : _IOFBF, BUFSIZ);
+        fflush(stdout);
+        stdout = counted;
+        counting = 1;
+    }
+}
+
+static int histogram_index(uint64_t value) { // 16 linear buckets per power of two
+    if (value < HISTOGRAM_SUB_BUCKETS) return value;
+    int magnitude = 63 - __builtin_clzll(value);
+    return (magnitude - 3) * HISTOGRAM_SUB_BUCKETS + ((value >> (magnitude - 4)) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+static uint64_t histogram_value(int index) { // highest value that lands in a bucket
+    if (index < HISTOGRAM_SUB_BUCKETS) return index;
+    int magnitude = index / HISTOGRAM_SUB_BUCKETS + 3;
+    uint64_t low = (uint64_t)(HISTOGRAM_SUB_BUCKETS + index % HISTOGRAM_SUB_BUCKETS) << (magnitude - 4);
+    return low + ((uint64_t)1 << (magnitude - 4)) - 1;
+}
+
+static uint64_t histogram_percentile(const Histogram *histogram, double percentile) {
+    uint64_t wanted = (uint64_t)(percentile / 100.0 * histogram->total + 0.5), seen = 0;
+    if (wanted < 1) wanted = 1;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= wanted) return histogram_value(i) < histogram->max ? histogram_value(i) : histogram->max;
+    }
+    return histogram->max;
+}
+
+ProfileScope profile_begin() {
+    return (ProfileScope){ monotonic_ns(), alloc_stats.allocs, alloc_stats.bytes };
+}
+
+void profile_end(int phase, ProfileScope *scope) {
+    profile_record(phase, monotonic_ns() - scope->start);
+    profiler.phase_allocs[phase] += alloc_stats.allocs - scope->allocs;
+    profiler.phase_alloc_bytes[phase] += alloc_stats.bytes - scope->bytes;
+}
+
+void profile_record(int phase, uint64_t ns) {
+    Histogram *histogram = &profiler.phases[phase];
+    histogram->counts[histogram_index(ns)]++;
+    if (!histogram->total || ns < histogram->min) histogram->min = ns;
+    if (ns > histogram->max) histogram->max = ns;
+    histogram->total++;
+    histogram->sum += ns;
+    profiler.last[phase] = ns;
+}
+
+void profile_frame_end() {
+    if (!profiler.enabled) return;
+    fflush(stdout); // the bytes of this frame reach counted_write now
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        profiler.last_frame[i] = profiler.frame[i];
+        profiler.totals[i] += profiler.frame[i];
+        profiler.frame[i] = 0;
+    }
+    profiler.frames++;
+}
+
+void print_profile_overlay() { // numbers of the last finished frame
+    if (!profiler.enabled) return;
+    printf("%sprofile%s", PURPLE, RESET);
+    for (int i = 0; i < PHASE_COUNT; i++) printf(" %s %.3fms", PHASE_NAMES[i], profiler.last[i] / 1e6);
+    printf(" | allocs %llu (%lluB) out %lluB bfs %llu\n", (unsigned long long)profiler.last_frame[COUNTER_ALLOCS],
+        (unsigned long long)profiler.last_frame[COUNTER_ALLOC_BYTES],
+        (unsigned long long)profiler.last_frame[COUNTER_BYTES_WRITTEN], (unsigned long long)profiler.last_frame[COUNTER_BFS_NODES]);
+}
+
+void profiler_dump() {
+    const double percentiles[] = {50, 90, 99, 99.9, 99.99, 100};
+    FILE *report = fopen(profiler.report_path ? profiler.report_path : "profile.txt", "w");
+    if (report == NULL) {
+        perror("fopen");
+        return;
+    }
+
+    fprintf(report, "frames %llu\n", (unsigned long long)profiler.frames);
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        fprintf(report, "%s total %llu, %.1f per frame\n", COUNTER_NAMES[i], (unsigned long long)profiler.totals[i],
+            profiler.frames ? (double)profiler.totals[i] / profiler.frames : 0.0);
+
+    for (int i = 0; i < PHASE_COUNT; i++) { // latencies in ns, every bucket within 1/16 of the recorded values
+        const Histogram *histogram = &profiler.phases[i];
+        if (!histogram->total) continue;
+        fprintf(report, "\n%s: %llu samples, mean %.0f, min %llu, max %llu\n", PHASE_NAMES[i], (unsigned long long)histogram->total,
+            (double)histogram->sum / histogram->total, (unsigned long long)histogram->min, (unsigned long long)histogram->max);
+        fprintf(report, "  %.2f allocs, %.1f bytes allocated per sample\n", (double)profiler.phase_allocs[i] / histogram->total,
+            (double)profiler.phase_alloc_bytes[i] / histogram->total);
+        for (int p = 0; p < (int)(sizeof(percentiles) / sizeof(percentiles[0])); p++)
+            fprintf(report, "  p%-6g %llu\n", percentiles[p], (unsigned long long)histogram_percentile(histogram, percentiles[p]));
+
+        fprintf(report, "  %12s %12s %10s\n", "value", "percentile", "count");
+        uint64_t seen = 0;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            if (!histogram->counts[b]) continue;
+            seen += histogram->counts[b];
+            fprintf(report, "  %12llu %12.6f %10llu\n", (unsigned long long)histogram_value(b),
+                (double)seen / histogram->total, (unsigned long long)histogram->counts[b]);
+        }
+    }
+    fclose(report);
+}
+
+/*
+    TELEMETRY (TA_TELEMETRY=1, the game pushes events into a ring that a writer thread drains to disk)
+*/
+static void *telemetry_writer(void *unused) {
+    uint64_t reported = 0; // drops already written as an event
+    for (;;) {
+        int stopping = atomic_load(&telemetry.stop); // read before the last drain, nothing is pushed after stop
+        uint64_t head = atomic_load_explicit(&telemetry.head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&telemetry.tail, memory_order_relaxed);
+
+        while (tail != head) { // one fwrite per contiguous run of the ring
+            size_t index = tail & (TELEMETRY_RING_SIZE - 1);
+            size_t count = head - tail < TELEMETRY_RING_SIZE - index ? head - tail : TELEMETRY_RING_SIZE - index;
+            fwrite(&telemetry.ring[index], sizeof(TelemetryRecord), count, telemetry.fp);
+            tail += count;
+            atomic_store_explicit(&telemetry.tail, tail, memory_order_release);
+        }
+
+        uint64_t dropped = atomic_load_explicit(&telemetry.dropped, memory_order_relaxed);
+        if (dropped != reported) {
+            TelemetryRecord record = { monotonic_ns() - telemetry.start, EVENT_DROPPED, 0, (int32_t)(dropped - reported) };
+            fwrite(&record, sizeof(record), 1, telemetry.fp);
+            reported = dropped;
+        }
+        fflush(telemetry.fp);
+
+        if (stopping) return unused;
+        nanosleep(&(struct timespec){ 0, TELEMETRY_FLUSH_NS }, NULL);
+    }
+}
+
+void telemetry_init() {
+    const char *env = getenv("TA_TELEMETRY");
+    if (env == NULL || !*env || !strcmp(env, "0")) return;
+
+    telemetry.fp = fopen(strcmp(env, "1") ? env : TELEMETRY_PATH, "ab");
+    if (telemetry.fp == NULL) {
+        perror("telemetry");
+        return;
+    }
+    fseek(telemetry.fp, 0, SEEK_END);
+    if (ftell(telemetry.fp) == 0) fwrite(TELEMETRY_MAGIC, 1, 8, telemetry.fp); // later sessions append to the same log
+    telemetry.start = monotonic_ns();
+    if (pthread_create(&telemetry.writer, NULL, telemetry_writer, NULL)) {
+        fclose(telemetry.fp);
+        return;
+    }
+    telemetry.enabled = 1;
+    atexit(telemetry_shutdown);
+}
+
+void telemetry_push(int type, int value) {
+    uint64_t head = atomic_load_explicit(&telemetry.head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&telemetry.tail, memory_order_acquire) == TELEMETRY_RING_SIZE) { // the writer is behind
+        atomic_fetch_add_explicit(&telemetry.dropped, 1, memory_order_relaxed);
+        return;
+    }
+    telemetry.ring[head & (TELEMETRY_RING_SIZE - 1)] = (TelemetryRecord){ monotonic_ns() - telemetry.start, type, current_arena, value };
+    atomic_store_explicit(&telemetry.head, head + 1, memory_order_release);
+}
+
+void telemetry_shutdown() {
+    if (!telemetry.enabled) return;
+    telemetry.enabled = 0;
+    atomic_store(&telemetry.stop, 1);
+    pthread_join(telemetry.writer, NULL);
+    fclose(telemetry.fp);
+}
+
+int run_telemetry(int count, char *args[]) {
+    int json = count == 2 && !strcmp(args[1], "json");
+    if (count < 1 || count > 2 || (count == 2 && !json && strcmp(args[1], "csv"))) {
+        fprintf(stderr, "usage: --telemetry <log file> [csv | json]\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *fp = fopen(args[0], "rb");
+    if (!fp) {
+        perror("fopen");
+        return EXIT_FAILURE;
+    }
+    char magic[8];
+    if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, TELEMETRY_MAGIC, 8)) {
+        fprintf(stderr, "%s: not a telemetry log\n", args[0]);
+        fclose(fp);
+        return EXIT_FAILURE;
+    }
+
+    TelemetryRecord record;
+    long records = 0;
+    if (json) printf("[\n");
+    else printf("time_ms,event,arena,value\n");
+    while (fread(&record, sizeof(record), 1, fp) == 1) {
+        const char *name = record.type < EVENT_COUNT ? EVENT_NAMES[record.type] : "unknown";
+        char value[16];
+        if (record.type == EVENT_PICKUP || record.type == EVENT_INPUT) snprintf(value, sizeof(value), record.value > ' ' && record.value < 127 && !strchr(",\"\\", record.value) ? "%c" : "%d", record.value);
+        else snprintf(value, sizeof(value), "%d", record.value);
+
+        if (json) printf("%s  {\"time_ms\": %.3f, \"event\": \"%s\", \"arena\": %u, \"value\": \"%s\"}", records ? ",\n" : "", record.time / 1e6, name, record.arena, value);
+        else printf("%.3f,%s,%u,%s\n", record.time / 1e6, name, record.arena, value);
+        records++;
+    }
+    if (json) printf("%s]\n", records ? "\n" : "");
+
+    fclose(fp);
+    return EXIT_SUCCESS;
+}
+
+/*
+    ACHIEVEMENTS (predicates grouped by the event they subscribe to, progress kept in achievements.dat)
+*/
+static const char *achievements_path() {
+    const char *env = getenv("TA_ACHIEVEMENTS");
+    return env && *env ? env : ACHIEVEMENTS_PATH;
+}
+
+static int compare_members(const void *a, const void *b) { // by group, then by target
+    const Achievement *x = &ACHIEVEMENTS[*(const int *)a], *y = &ACHIEVEMENTS[*(const int *)b];
+    if (x->event != y->event) return x->event - y->event;
+    if (x->filter != y->filter) return x->filter - y->filter;
+    if (x->kind != y->kind) return x->kind - y->kind;
+    return x->target - y->target;
+}
+
+static int achievement_unlocked(int id) {
+    return achievements.unlocked[id / 8] >> (id % 8) & 1;
+}
+
+static void achievement_unlock(int id) {
+    if (achievement_unlocked(id)) return;
+    achievements.unlocked[id / 8] |= 1 << (id % 8);
+    achievements.banner = ACHIEVEMENTS[id].name;
+    achievements.dirty = 1;
+}
+
+static void achievements_catch_up() { // group cursors from the counters & unlocked bits, after loading
+    for (int g = 0; g < achievements.group_count; g++) {
+        AchievementGroup *group = &achievements.groups[g];
+        const int *members = &achievements.members[group->first];
+        if (group->kind == ACHIEVE_COUNT) {
+            group->next = 0;
+            while (group->next < group->count && ACHIEVEMENTS[members[group->next]].target <= group->counter) achievement_unlock(members[group->next++]);
+        }
+        else {
+            group->next = group->count;
+            while (group->next > 0 && achievement_unlocked(members[group->next - 1])) group->next--;
+        }
+    }
+    achievements.banner = NULL; // nothing new was earned
+}
+
+void achievements_init() {
+    for (int i = 0; i < ACHIEVEMENT_COUNT; i++) achievements.members[i] = i;
+    qsort(achievements.members, ACHIEVEMENT_COUNT, sizeof(int), compare_members);
+
+    achievements.group_count = 0;
+    for (int i = 0; i < ACHIEVEMENT_COUNT; i++) {
+        const Achievement *achievement = &ACHIEVEMENTS[achievements.members[i]];
+        AchievementGroup *last = achievements.group_count ? &achievements.groups[achievements.group_count - 1] : NULL;
+        if (last && last->event == achievement->event && last->filter == achievement->filter && last->kind == achievement->kind) last->count++;
+        else achievements.groups[achievements.group_count++] = (AchievementGroup){ achievement->event, achievement->filter, achievement->kind, 0, i, 1, 0 };
+    }
+    for (int e = 0, g = 0; e <= EVENT_COUNT; e++) { // groups are sorted by event
+        while (g < achievements.group_count && achievements.groups[g].event < e) g++;
+        achievements.first_group[e] = g;
+    }
+
+    int fd = open(achievements_path(), O_RDONLY);
+    if (fd != -1) {
+        AchievementHeader header;
+        if (read(fd, &header, sizeof(header)) == sizeof(header) && !memcmp(header.magic, ACHIEVEMENTS_MAGIC, sizeof(header.magic)) &&
+            header.achievements >= 0 && header.achievements <= 8 * 1024) { // older files know fewer achievements, never more than this
+            unsigned char unlocked[(header.achievements + 7) / 8 + 1];
+            if (read(fd, unlocked, (header.achievements + 7) / 8) == (header.achievements + 7) / 8) {
+                for (int i = 0; i < header.achievements && i < ACHIEVEMENT_COUNT; i++) {
+                    if (unlocked[i / 8] >> (i % 8) & 1) achievements.unlocked[i / 8] |= 1 << (i % 8);
+                }
+            }
+            AchievementRecord record;
+            for (int i = 0; i < header.groups && read(fd, &record, sizeof(record)) == sizeof(record); i++) { // counters follow their group, not its position
+                for (int g = 0; g < achievements.group_count; g++) {
+                    AchievementGroup *group = &achievements.groups[g];
+                    if (group->event == record.event && group->filter == record.filter && group->kind == record.kind) group->counter = record.counter;
+                }
+            }
+        }
+        close(fd);
+    }
+
+    achievements_catch_up();
+    achievements.dirty = 0;
+    achievements.loaded = 1;
+    atexit(achievements_save);
+}
+
+void achievements_on(int type, int value) {
+    for (int g = achievements.first_group[type]; g < achievements.first_group[type + 1]; g++) { // a handful of groups, however many achievements
+        AchievementGroup *group = &achievements.groups[g];
+        const int *members = &achievements.members[group->first];
+        if (group->filter && group->filter != value) continue;
+
+        if (group->kind == ACHIEVE_COUNT) {
+            group->counter++;
+            achievements.dirty = 1;
+            while (group->next < group->count && ACHIEVEMENTS[members[group->next]].target <= group->counter) achievement_unlock(members[group->next++]);
+        }
+        else { // every target at or above the value is met
+            while (group->next > 0 && ACHIEVEMENTS[members[group->next - 1]].target >= value) achievement_unlock(members[--group->next]);
+        }
+    }
+}
+
+void achievements_save() {
+    if (!achievements.loaded || !achievements.dirty) return;
+
+    char temp[MAX_PATH_LENGTH];
+    snprintf(temp, sizeof(temp), "%s.tmp", achievements_path());
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) return; // progress stays in memory, the next save tries again
+
+    AchievementHeader header = { ACHIEVEMENTS_MAGIC, ACHIEVEMENT_COUNT, achievements.group_count };
+    AchievementRecord records[ACHIEVEMENT_COUNT];
+    for (int g = 0; g < achievements.group_count; g++) {
+        const AchievementGroup *group = &achievements.groups[g];
+        records[g] = (AchievementRecord){ group->event, group->filter, group->kind, 0, group->counter };
+    }
+    int ok = write(fd, &header, sizeof(header)) == sizeof(header) &&
+        write(fd, achievements.unlocked, sizeof(achievements.unlocked)) == sizeof(achievements.unlocked) &&
+        write(fd, records, achievements.group_count * sizeof(AchievementRecord)) == (ssize_t)(achievements.group_count * sizeof(AchievementRecord));
+    close(fd);
+
+    if (ok && rename(temp, achievements_path()) == 0) achievements.dirty = 0;
+    else unlink(temp);
+}
+
+void print_achievement_banner() {
+    if (!achievements.banner) return;
+    printf("%sACHIEVEMENT%s: %s%s%s\n", ORANGE, RESET, LIGHT_ORANGE, achievements.banner, RESET);
+    achievements.banner = NULL;
+}
+
+int run_achievements(int count, char *args[]) {
+    if (count) {
+        fprintf(stderr, "usage: --achievements\n");
+        return EXIT_FAILURE;
+    }
+    achievements_init();
+    achievements.loaded = 0; // only looking, nothing to save on exit
+
+    int done = 0;
+    for (int i = 0; i < ACHIEVEMENT_COUNT; i++) {
+        const Achievement *achievement = &ACHIEVEMENTS[i];
+        printf("[%c] %-16s %s", achievement_unlocked(i) ? 'x' : ' ', achievement->name, achievement->description);
+        for (int g = 0; g < achievements.group_count && achievement->kind == ACHIEVE_COUNT && !achievement_unlocked(i); g++) {
+            const AchievementGroup *group = &achievements.groups[g];
+            if (group->event == achievement->event && group->filter == achievement->filter && group->kind == achievement->kind)
+                printf(" (%lld/%d)", (long long)group->counter, achievement->target);
+        }
+        printf("\n");
+        done += achievement_unlocked(i);
+    }
+    printf("%d of %d unlocked\n", done, ACHIEVEMENT_COUNT);
+    return EXIT_SUCCESS;
+}
+
+/*
+    WORLD STORAGE (chunked worlds that are streamed from disk instead of loaded whole)
+*/
+World* world_create(const char *path, long rows, long cols) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        perror("open");
+        return NULL;
+    }
+
+    WorldHeader header = {0};
+    memcpy(header.magic, WORLD_MAGIC, sizeof(header.magic));
+    header.rows = rows;
+    header.cols = cols;
+    header.chunk_size = CHUNK_SIZE;
+
+    long chunks = ((rows + CHUNK_SIZE - 1) / CHUNK_SIZE) * ((cols + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header) || // untouched chunks stay sparse (zero bytes = empty tiles, tick 0)
+        ftruncate(fd, sizeof(header) + (off_t)chunks * (CHUNK_BYTES + sizeof(int64_t)) + sizeof(WorldTrailer)) == -1) {
+        perror("write");
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+
+    return world_open(path, WORLD_DEFAULT_BUDGET);
+}
+
+static off_t world_chunk_tick(World *world, long index) { // where the tick of a chunk is kept
+    return sizeof(WorldHeader) + (off_t)world->chunk_rows * world->chunk_cols * CHUNK_BYTES + index * (off_t)sizeof(int64_t);
+}
+
+static off_t world_trailer(World *world) {
+    return world_chunk_tick(world, world->chunk_rows * world->chunk_cols);
+}
+
+World* world_open(const char *path, long budget) {
+    int fd = open(path, O_RDWR);
+    if (fd == -1) {
+        perror("open");
+        return NULL;
+    }
+
+    WorldHeader header;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        memcmp(header.magic, WORLD_MAGIC, sizeof(header.magic)) || header.chunk_size != CHUNK_SIZE) {
+        fprintf(stderr, "%s: not a world file\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    World *world = (World *)game_calloc(1, sizeof(World));
+    if (world == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    world->fd = fd;
+    world->rows = header.rows;
+    world->cols = header.cols;
+    world->chunk_rows = (header.rows + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    world->chunk_cols = (header.cols + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    WorldTrailer trailer; // files written before the simulation have none ~ tick 0, nothing pending
+    struct stat info;
+    off_t events_at = world_trailer(world) + sizeof(trailer);
+    if (pread(fd, &trailer, sizeof(trailer), world_trailer(world)) != sizeof(trailer)) memset(&trailer, 0, sizeof(trailer));
+    int damaged = fstat(fd, &info) == -1 || trailer.tick < 0 || trailer.events < 0 || trailer.events > INT32_MAX / 2 ||
+        (trailer.events && trailer.events > (info.st_size - events_at) / (off_t)sizeof(WorldEvent)); // the count is never trusted past the end of the file
+    world->tick = trailer.tick;
+    world->event_capacity = trailer.events > WORLD_FIRST_EVENTS ? trailer.events : WORLD_FIRST_EVENTS;
+    world->events = damaged ? NULL : (WorldEvent *)game_malloc(world->event_capacity * sizeof(WorldEvent));
+    if (!damaged && world->events == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    world->event_count = damaged ? 0 : trailer.events;
+    if (!damaged && trailer.events && pread(fd, world->events, trailer.events * sizeof(WorldEvent), events_at) != (ssize_t)(trailer.events * sizeof(WorldEvent))) damaged = 1;
+    for (int i = 0; !damaged && i < world->event_count; i++) { // stored as a heap already, on tiles of this world
+        const WorldEvent *event = &world->events[i];
+        if (event->row < 0 || event->row >= world->rows || event->col < 0 || event->col >= world->cols || (i && world->events[(i - 1) / 2].tick > event->tick)) damaged = 1;
+    }
+    if (damaged) {
+        fprintf(stderr, "%s: damaged world file\n", path);
+        game_free(world->events);
+        game_free(world);
+        close(fd);
+        return NULL;
+    }
+
+    world->slot_count = budget / sizeof(Chunk); // memory budget ~ fixed number of resident chunks
+    if (world->slot_count < WORLD_MIN_CHUNKS) world->slot_count = WORLD_MIN_CHUNKS;
+    int buckets = 1;
+    while (buckets < world->slot_count) buckets *= 2;
+    world->bucket_mask = buckets - 1;
+
+    world->slots = (Chunk *)game_malloc(world->slot_count * sizeof(Chunk));
+    world->buckets = (int *)game_malloc(buckets * sizeof(int));
+    if (world->slots == NULL || world->buckets == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < buckets; i++) world->buckets[i] = -1;
+    for (int i = 0; i < world->slot_count; i++) { // every slot starts free, at the back of the lru list
+        world->slots[i].index = -1;
+        world->slots[i].dirty = 0;
+        world->slots[i].prev = i ? &world->slots[i - 1] : NULL;
+        world->slots[i].next = i + 1 < world->slot_count ? &world->slots[i + 1] : NULL;
+    }
+    world->lru_front = &world->slots[0];
+    world->lru_back = &world->slots[world->slot_count - 1];
+    return world;
+}
+
+static void world_write_back(World *world, Chunk *chunk) {
+    if (!chunk->dirty) return;
+    if (pwrite(world->fd, chunk->tiles, CHUNK_BYTES, sizeof(WorldHeader) + (off_t)chunk->index * CHUNK_BYTES) != CHUNK_BYTES ||
+        pwrite(world->fd, &chunk->tick, sizeof(chunk->tick), world_chunk_tick(world, chunk->index)) != sizeof(chunk->tick)) {
+        perror("pwrite");
+        exit(EXIT_FAILURE);
+    }
+    chunk->dirty = 0;
+    world->writebacks++;
+}
+
+static void world_unlink_bucket(World *world, Chunk *chunk) {
+    int slot = chunk - world->slots;
+    int *link = &world->buckets[chunk->index & world->bucket_mask];
+    while (*link != slot) link = &world->slots[*link].bucket_next;
+    *link = chunk->bucket_next;
+}
+
+static void world_catch_up(World *world, Chunk *chunk) { // closed form of every growth tick the chunk missed, O(1) until the next one
+    int64_t steps = world->tick / WORLD_GROW_TICKS - chunk->tick / WORLD_GROW_TICKS;
+    chunk->tick = world->tick;
+    if (steps <= 0) return;
+
+    int grown = 0;
+    for (int i = 0; i < CHUNK_BYTES; i++) {
+        char tile = chunk->tiles[i];
+        if (tile != WORLD_SEED && tile != WORLD_SAPLING) continue;
+        chunk->tiles[i] = (tile == WORLD_SAPLING) + steps >= 2 ? WORLD_TREE : WORLD_SAPLING; // a seed needs two stages, a sapling one
+        grown++;
+    }
+    if (grown) chunk->dirty = 1;
+    world->catch_ups++;
+    world->regrown += grown;
+}
+
+static Chunk* world_chunk(World *world, long index) { // returns the resident chunk, loading / evicting through the lru
+    int slot = world->buckets[index & world->bucket_mask];
+    while (slot != -1 && world->slots[slot].index != index) slot = world->slots[slot].bucket_next;
+
+    Chunk *chunk;
+    if (slot != -1) chunk = &world->slots[slot];
+    else { // miss ~ reuse the least recently used slot
+        chunk = world->lru_back;
+        if (chunk->index != -1) {
+            world_write_back(world, chunk);
+            world_unlink_bucket(world, chunk);
+            world->evictions++;
+        }
+
+        ssize_t got = pread(world->fd, chunk->tiles, CHUNK_BYTES, sizeof(WorldHeader) + (off_t)index * CHUNK_BYTES);
+        if (got < 0) {
+            perror("pread");
+            exit(EXIT_FAILURE);
+        }
+        if (got < CHUNK_BYTES) memset(chunk->tiles + got, 0, CHUNK_BYTES - got);
+        if (pread(world->fd, &chunk->tick, sizeof(chunk->tick), world_chunk_tick(world, index)) != sizeof(chunk->tick)) chunk->tick = 0;
+        chunk->index = index;
+        chunk->dirty = 0;
+        chunk->bucket_next = world->buckets[index & world->bucket_mask];
+        world->buckets[index & world->bucket_mask] = chunk - world->slots;
+        world->loads++;
+    }
+
+    if (chunk != world->lru_front) { // move to the front of the lru list
+        chunk->prev->next = chunk->next;
+        if (chunk->next) chunk->next->prev = chunk->prev;
+        else world->lru_back = chunk->prev;
+        chunk->prev = NULL;
+        chunk->next = world->lru_front;
+        world->lru_front->prev = chunk;
+        world->lru_front = chunk;
+    }
+    world_catch_up(world, chunk);
+    return chunk;
+}
+
+char world_get(World *world, long row, long col) {
+    if (row < 0 || row >= world->rows || col < 0 || col >= world->cols) return ' ';
+    Chunk *chunk = world_chunk(world, (row / CHUNK_SIZE) * world->chunk_cols + col / CHUNK_SIZE);
+    char tile = chunk->tiles[(row % CHUNK_SIZE) * CHUNK_SIZE + col % CHUNK_SIZE];
+    return tile ? tile : ' ';
+}
+
+void world_set(World *world, long row, long col, char tile) {
+    if (row < 0 || row >= world->rows || col < 0 || col >= world->cols) return;
+    Chunk *chunk = world_chunk(world, (row / CHUNK_SIZE) * world->chunk_cols + col / CHUNK_SIZE);
+    chunk->tiles[(row % CHUNK_SIZE) * CHUNK_SIZE + col % CHUNK_SIZE] = tile;
+    chunk->dirty = 1;
+}
+
+void world_focus(World *world, long row, long col, int radius) { // keeps the chunks around the player resident
+    long chunk_row = row / CHUNK_SIZE, chunk_col = col / CHUNK_SIZE;
+    for (long i = chunk_row - radius; i <= chunk_row + radius; i++) {
+        for (long j = chunk_col - radius; j <= chunk_col + radius; j++) {
+            if (i >= 0 && i < world->chunk_rows && j >= 0 && j < world->chunk_cols) world_chunk(world, i * world->chunk_cols + j);
+        }
+    }
+}
+
+void world_flush(World *world) {
+    for (int i = 0; i < world->slot_count; i++) if (world->slots[i].index != -1) world_write_back(world, &world->slots[i]);
+
+    WorldTrailer trailer = { world->tick, world->event_count };
+    size_t events = world->event_count * sizeof(WorldEvent);
+    if (pwrite(world->fd, &trailer, sizeof(trailer), world_trailer(world)) != sizeof(trailer) ||
+        (events && pwrite(world->fd, world->events, events, world_trailer(world) + sizeof(trailer)) != (ssize_t)events) ||
+        ftruncate(world->fd, world_trailer(world) + sizeof(trailer) + events) == -1) {
+        perror("pwrite");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void world_close(World *world) {
+    world_flush(world);
+    close(world->fd);
+    game_free(world->slots);
+    game_free(world->buckets);
+    game_free(world->events);
+    game_free(world);
+}
+
+/*
+    WORLD SIMULATION (lazy: chunks catch up when they are used, events fire from a heap wherever they are)
+*/
+static void world_sift_down(World *world, int i) {
+    WorldEvent *heap = world->events;
+    for (;;) {
+        int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < world->event_count && heap[left].tick < heap[smallest].tick) smallest = left;
+        if (right < world->event_count && heap[right].tick < heap[smallest].tick) smallest = right;
+        if (smallest == i) return;
+        WorldEvent swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+void world_schedule(World *world, int delay, long row, long col, char glyph) {
+    if (world->event_count == world->event_capacity) {
+        WorldEvent *events = (WorldEvent *)game_realloc(world->events, 2 * world->event_capacity * sizeof(WorldEvent));
+        if (events == NULL) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        world->events = events;
+        world->event_capacity *= 2;
+    }
+    int i = world->event_count++;
+    WorldEvent event = { world->tick + (delay > 0 ? delay : 1), row, col, glyph, 0 };
+    while (i && world->events[(i - 1) / 2].tick > event.tick) { // sift up
+        world->events[i] = world->events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    world->events[i] = event;
+}
+
+void world_advance(World *world) { // nothing here depends on the size of the world
+    world->tick++;
+    while (world->event_count && world->events[0].tick <= world->tick) {
+        WorldEvent event = world->events[0];
+        world->events[0] = world->events[--world->event_count];
+        world_sift_down(world, 0);
+        if (world_get(world, event.row, event.col) == ' ') world_set(world, event.row, event.col, event.glyph); // built over meanwhile ~ gone
+        world->fired++;
+    }
+}
+
+char world_gather(World *world, long row, long col) {
+    char tile = world_get(world, row, col);
+    if (tile == WORLD_TREE) world_set(world, row, col, WORLD_SEED); // grows back from the stump
+    else if (tile == WORLD_ORE) {
+        world_set(world, row, col, '\0');
+        world_schedule(world, WORLD_ORE_TICKS, row, col, WORLD_ORE);
+    }
+    else return '\0';
+    return tile;
+}
+
+int run_world_sim(int count, char *args[]) {
+    if (count < 1 || count > 2 || (count == 2 && atol(args[1]) <= 0)) {
+        fprintf(stderr, "usage: --world-sim <world file> [ticks]\n");
+        return EXIT_FAILURE;
+    }
+    World *world = world_open(args[0], WORLD_DEFAULT_BUDGET);
+    if (world == NULL) return EXIT_FAILURE;
+    if (world->rows < 3 || world->cols < 3) {
+        fprintf(stderr, "%s: too small\n", args[0]);
+        world_close(world);
+        return EXIT_FAILURE;
+    }
+
+    long ticks = count == 2 ? atol(args[1]) : 100000;
+    long row = world->rows / 2, col = 1, direction = 1, wood = 0, ore = 0;
+    uint64_t began = monotonic_ns(), worst = 0;
+    for (long t = 0; t < ticks; t++) { // walks along a row and back: plants & ore veins on the way out, harvests on the way back
+        uint64_t start = monotonic_ns();
+        world_advance(world);
+        world_focus(world, row, col, 1); // what the player sees is up to date
+        char tile = world_gather(world, row - 1, col);
+        if (tile == WORLD_TREE) wood++;
+        else if (tile == WORLD_ORE) ore++;
+        else if (direction > 0 && world_get(world, row - 1, col) == ' ') world_set(world, row - 1, col, col % 8 ? WORLD_SEED : WORLD_ORE);
+        if (col + direction < 1 || col + direction > world->cols - 2) direction = -direction;
+        col += direction;
+        uint64_t spent = monotonic_ns() - start;
+        if (spent > worst) worst = spent;
+    }
+
+    printf("%s: %ld ticks (world tick %lld), %.0f ns per tick, worst %.1f us, %ld chunk catch-ups, %ld plants grown, %ld events fired, "
+        "%d pending, %ld wood, %ld ore, %ld loads, %ld evictions\n", args[0], ticks, (long long)world->tick, (double)(monotonic_ns() - began) / ticks,
+        worst / 1e3, world->catch_ups, world->regrown, world->fired, world->event_count, wood, ore, world->loads, world->evictions);
+    world_close(world);
+    return EXIT_SUCCESS;
+}
+
+World* world_import_arena(const char *file_name, const char *path) { // streams a text arena of any width into a world file
+    char source[MAX_PATH_LENGTH];
+    arena_path(file_name, source);
+
+    FILE *fp = fopen(source, "r");
+    if (!fp) {
+        perror("fopen");
+        return NULL;
+    }
+
+    long rows = 0, cols = 0, length = 0;
+    int c;
+    while ((c = fgetc(fp)) != EOF) { // first pass ~ dimensions without any line buffer
+        if (c == '\n') { rows++; length = 0; }
+        else if (++length > cols) cols = length;
+    }
+    if (length) rows++;
+
+    World *world = world_create(path, rows, cols);
+    if (world == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+
+    rewind(fp);
+    long row = 0, col = 0;
+    while ((c = fgetc(fp)) != EOF) {
+        if (c == '\n') { row++; col = 0; }
+        else world_set(world, row, col++, c == ' ' ? '\0' : c); // spaces stay sparse on disk
+    }
+
+    fclose(fp);
+    return world;
+}
+
+int run_make_world(int count, char *args[]) {
+    if (count != 2) {
+        fprintf(stderr, "usage: --make-world <arena file | ROWSxCOLS> <world file>\n");
+        return EXIT_FAILURE;
+    }
+
+    World *world;
+    long rows, cols;
+    if (sscanf(args[0], "%ldx%ld", &rows, &cols) == 2 && rows > 2 && cols > 2) { // empty walled world
+        world = world_create(args[1], rows, cols);
+        if (world == NULL) return EXIT_FAILURE;
+        for (long j = 0; j < cols; j++) {
+            world_set(world, 0, j, '=');
+            world_set(world, rows - 1, j, '=');
+        }
+        for (long i = 1; i < rows - 1; i++) {
+            world_set(world, i, 0, '|');
+            world_set(world, i, cols - 1, '|');
+        }
+        world_set(world, rows / 2, cols / 2, 'p');
+    }
+    else world = world_import_arena(args[0], args[1]);
+    if (world == NULL) return EXIT_FAILURE;
+
+    printf("%s: %ldx%ld tiles, %ld chunks, %ld loads, %ld evictions, %ld write backs, %ld KB resident\n", args[1], world->rows, world->cols,
+        world->chunk_rows * world->chunk_cols, world->loads, world->evictions, world->writebacks, (long)(world->slot_count * sizeof(Chunk) / 1024));
+    world_close(world);
+    return EXIT_SUCCESS;
+}
+
+/*
+    LEADERBOARD (append-only checksummed log, compacted into a sorted table that is mapped for queries)
+*/
+static uint32_t crc32_bytes(const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static uint32_t leaderboard_crc(const LeaderboardEntry *entry) {
+    return crc32_bytes(entry, offsetof(LeaderboardEntry, crc));
+}
+
+static int compare_entries(const void *a, const void *b) { // best first: score, then coins, then the earlier run
+    const LeaderboardEntry *x = (const LeaderboardEntry *)a, *y = (const LeaderboardEntry *)b;
+    if (x->score != y->score) return x->score > y->score ? -1 : 1;
+    if (x->coins != y->coins) return x->coins > y->coins ? -1 : 1;
+    return (x->time > y->time) - (x->time < y->time);
+}
+
+static void leaderboard_path(char *path, const char *extension) {
+    const char *base = getenv("TA_LEADERBOARD");
+    snprintf(path, MAX_PATH_LENGTH, "%s%s", base && *base ? base : LEADERBOARD_PATH, extension);
+}
+
+static int leaderboard_log_header(int fd, LeaderboardHeader *header) { // writes one into an empty log, 0 = not a log
+    struct stat info;
+    if (fstat(fd, &info) == -1) return 0;
+    if (info.st_size < (off_t)sizeof(*header)) {
+        memset(header, 0, sizeof(*header));
+        memcpy(header->magic, LEADERBOARD_LOG_MAGIC, sizeof(header->magic));
+        return ftruncate(fd, 0) != -1 && write(fd, header, sizeof(*header)) == sizeof(*header);
+    }
+    return pread(fd, header, sizeof(*header), 0) == sizeof(*header) && !memcmp(header->magic, LEADERBOARD_LOG_MAGIC, sizeof(header->magic));
+}
+
+int leaderboard_open(Leaderboard *board, int lock) {
+    char path[MAX_PATH_LENGTH];
+    memset(board, 0, sizeof(*board));
+    leaderboard_path(path, ".log");
+    board->log_fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (board->log_fd == -1) return -1;
+    if (flock(board->log_fd, LOCK_EX) == -1) { // the log header may have to be written, readers downgrade after
+        close(board->log_fd);
+        return -1;
+    }
+
+    LeaderboardHeader log_header;
+    if (!leaderboard_log_header(board->log_fd, &log_header)) {
+        close(board->log_fd);
+        errno = EINVAL; // not a leaderboard log
+        return -1;
+    }
+    if (lock == LOCK_SH) flock(board->log_fd, LOCK_SH);
+
+    leaderboard_path(path, ".tbl");
+    int fd = open(path, O_RDONLY);
+    if (fd != -1) {
+        LeaderboardHeader header;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(header) && pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+            !memcmp(header.magic, LEADERBOARD_TABLE_MAGIC, sizeof(header.magic)) &&
+            (off_t)(sizeof(header) + header.count * sizeof(LeaderboardEntry)) <= info.st_size) {
+            board->map_size = info.st_size;
+            board->map = mmap(NULL, board->map_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (board->map == MAP_FAILED) board->map = NULL;
+            else {
+                board->table = (const LeaderboardEntry *)((const char *)board->map + sizeof(header));
+                board->table_count = header.count;
+                board->generation = header.generation;
+            }
+        }
+        close(fd); // the mapping stays valid
+    }
+
+    if (log_header.generation != board->generation && lock == LOCK_EX) { // a compaction died after writing the table, its log is merged already
+        log_header.generation = board->generation;
+        if (ftruncate(board->log_fd, 0) == -1 || write(board->log_fd, &log_header, sizeof(log_header)) != sizeof(log_header)) { // O_APPEND ~ every write goes to the end
+            leaderboard_close(board);
+            return -1;
+        }
+    }
+
+    if (log_header.generation == board->generation) { // an older log was already merged into the table
+        struct stat info;
+        fstat(board->log_fd, &info);
+        long count = (info.st_size - sizeof(LeaderboardHeader)) / sizeof(LeaderboardEntry); // a torn last entry is left out
+        board->log = (LeaderboardEntry *)game_malloc((count + 1) * sizeof(LeaderboardEntry));
+        if (board->log == NULL) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        if (pread(board->log_fd, board->log, count * sizeof(LeaderboardEntry), sizeof(LeaderboardHeader)) != (ssize_t)(count * sizeof(LeaderboardEntry))) count = 0;
+        for (long i = 0; i < count; i++) if (board->log[i].crc == leaderboard_crc(&board->log[i])) board->log[board->log_count++] = board->log[i];
+        qsort(board->log, board->log_count, sizeof(LeaderboardEntry), compare_entries);
+    }
+    return 0;
+}
+
+void leaderboard_close(Leaderboard *board) {
+    if (board->map) munmap(board->map, board->map_size);
+    game_free(board->log);
+    close(board->log_fd); // drops the lock
+}
+
+static int leaderboard_compact(Leaderboard *board) { // table + log -> new table, then the log starts over (exclusive lock held)
+    char path[MAX_PATH_LENGTH], temp[MAX_PATH_LENGTH];
+    leaderboard_path(path, ".tbl");
+    leaderboard_path(temp, ".tbl.tmp");
+
+    FILE *fp = fopen(temp, "w");
+    if (!fp) return -1;
+    LeaderboardHeader header = {0};
+    memcpy(header.magic, LEADERBOARD_TABLE_MAGIC, sizeof(header.magic));
+    header.generation = board->generation + 1;
+    header.count = board->table_count + board->log_count;
+    fwrite(&header, sizeof(header), 1, fp);
+
+    long i = 0, j = 0;
+    while (i < board->table_count || j < board->log_count) { // both are sorted ~ one streaming merge
+        if (j == board->log_count || (i < board->table_count && compare_entries(&board->table[i], &board->log[j]) <= 0)) fwrite(&board->table[i++], sizeof(LeaderboardEntry), 1, fp);
+        else fwrite(&board->log[j++], sizeof(LeaderboardEntry), 1, fp);
+    }
+
+    if (fflush(fp) || fsync(fileno(fp)) || ferror(fp)) {
+        fclose(fp);
+        unlink(temp);
+        return -1;
+    }
+    fclose(fp);
+    if (rename(temp, path) == -1) return -1; // readers keep their mapping of the old table
+
+    // a crash before the log is reset leaves it one generation behind ~ ignored, never merged twice
+    LeaderboardHeader log_header = {0};
+    memcpy(log_header.magic, LEADERBOARD_LOG_MAGIC, sizeof(log_header.magic));
+    log_header.generation = header.generation;
+    if (ftruncate(board->log_fd, 0) == -1 || write(board->log_fd, &log_header, sizeof(log_header)) != sizeof(log_header)) return -1;
+    return 0;
+}
+
+int leaderboard_record(int score, int coins, int arenas) {
+    Leaderboard board;
+    if (leaderboard_open(&board, LOCK_EX) == -1) return -1; // other game processes wait here
+
+    LeaderboardEntry entry = { (int64_t)time(NULL), score, coins, arenas, 0 };
+    entry.crc = leaderboard_crc(&entry);
+    int status = write(board.log_fd, &entry, sizeof(entry)) == sizeof(entry) ? 0 : -1; // O_APPEND, one write per entry
+
+    if (!status && board.log_count + 1 >= LEADERBOARD_LOG_LIMIT) { // full ~ merge it into the table
+        long i = board.log_count++;
+        for (; i > 0 && compare_entries(&entry, &board.log[i - 1]) < 0; i--) board.log[i] = board.log[i - 1];
+        board.log[i] = entry;
+        status = leaderboard_compact(&board);
+    }
+    leaderboard_close(&board);
+    return status;
+}
+
+int leaderboard_top(Leaderboard *board, int k, LeaderboardEntry *out) {
+    long i = 0, j = 0;
+    int count = 0;
+    while (count < k && (i < board->table_count || j < board->log_count)) {
+        if (j == board->log_count || (i < board->table_count && compare_entries(&board->table[i], &board->log[j]) <= 0)) out[count++] = board->table[i++];
+        else out[count++] = board->log[j++];
+    }
+    return count;
+}
+
+long leaderboard_rank(Leaderboard *board, int score) {
+    long low = 0, high = board->table_count; // first table entry that does not beat the score
+    while (low < high) {
+        long middle = low + (high - low) / 2;
+        if (board->table[middle].score > score) low = middle + 1;
+        else high = middle;
+    }
+    long better = low;
+    for (long i = 0; i < board->log_count && board->log[i].score > score; i++) better++; // the log is small and sorted
+    return better + 1;
+}
+
+int run_leaderboard(int count, char *args[]) {
+    if (count >= 2 && !strcmp(args[0], "add")) { // bot & server runs
+        if (leaderboard_record(atoi(args[1]), count > 2 ? atoi(args[2]) : 0, count > 3 ? atoi(args[3]) : 0) == -1) {
+            perror("leaderboard");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    Leaderboard board;
+    if (leaderboard_open(&board, LOCK_SH) == -1) {
+        perror("leaderboard");
+        return EXIT_FAILURE;
+    }
+
+    if (count == 2 && !strcmp(args[0], "rank")) printf("rank %ld of %ld\n", leaderboard_rank(&board, atoi(args[1])), board.table_count + board.log_count);
+    else if (count <= 2 && (!count || !strcmp(args[0], "top"))) {
+        int k = count == 2 ? atoi(args[1]) : 10;
+        if (k < 0) k = 0;
+        LeaderboardEntry *top = (LeaderboardEntry *)game_malloc((k + 1) * sizeof(LeaderboardEntry));
+        if (top == NULL) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        int found = leaderboard_top(&board, k, top);
+        for (int i = 0; i < found; i++) {
+            char date[32];
+            time_t when = (time_t)top[i].time;
+            strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&when));
+            printf("%3d. %6d  $%-4d arenas %-3d %s\n", i + 1, top[i].score, top[i].coins, top[i].arenas, date);
+        }
+        game_free(top);
+    }
+    else fprintf(stderr, "usage: --leaderboard [top K | rank SCORE | add SCORE [COINS [ARENAS]]]\n");
+
+    leaderboard_close(&board);
+    return EXIT_SUCCESS;
+}
+
+/*
+    SOLVER (headless level validation: ./version1 --solve [arena files])
+*/
+#define GAME_INPUTS "wasd123bzy" // every input that can change the game state (+ upper case wasd & bzy)
+#define SOLVER_MOVES "wasd123" // the ones the solver tries, building is left out: every wall it could place would multiply the states
+#define SOLVER_MAX_STATES 1000000 // search gives up after this many distinct states
+
+typedef struct { // everything besides the arena that the game rules read or write
+    int player_x, player_y;
+    int player_h;
+    int weapon_flag;
+    int death_flag;
+    int coins;          // buy triggers read them, the score is never read by the rules so it is left out
+    char items[MAX_INVENTORY_ITEMS];
+    unsigned char timers[TIMER_KIND_COUNT]; // ticks until the pending timer of every kind fires, 0 = none
+    char spikes_raised;
+} SolverState;
+
+typedef struct {
+    SolverState state;
+    uint64_t key;   // zobrist key of state + arena snapshot
+    int parent;     // index of the previous node (-1 for the start)
+    int g;          // moves made so far
+    char move;      // input that led here
+} SolverNode;
+
+typedef struct {
+    int f, g, node;
+} SolverEntry;
+
+typedef struct {
+    int rows, cols;
+    int snapshot_size;  // bytes of one arena snapshot
+    SolverNode *nodes;
+    char *snapshots;    // one arena snapshot per node
+    int count, capacity;
+    int *table;         // transposition table (open addressing, -1 = empty)
+    int table_mask;
+    SolverEntry *heap;  // open list ordered by f, then deepest g
+    int heap_count, heap_capacity;
+    uint64_t *snapshot_keys; // zobrist keys: [snapshot byte][value]
+    uint64_t *pos_keys;      // zobrist keys: [row], then [rows + col]
+    uint64_t health_keys[512];
+    uint64_t coin_keys[256];
+    uint64_t item_keys[MAX_INVENTORY_ITEMS][128];
+    uint64_t flag_keys[3];
+    uint64_t timer_keys[TIMER_KIND_COUNT][256];
+    int *heuristic;     // distance field to the exit, -1 = exit unreachable
+} Solver;
+
+static uint64_t splitmix64(uint64_t *seed) {
+    uint64_t z = (*seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void solver_init_keys(Solver *solver) {
+    uint64_t seed = 2024;
+    solver->snapshot_keys = (uint64_t *)game_malloc(solver->snapshot_size * 256 * sizeof(uint64_t));
+    if (solver->snapshot_keys == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < solver->snapshot_size * 256; i++) solver->snapshot_keys[i] = splitmix64(&seed);
+    solver->pos_keys = (uint64_t *)game_malloc((solver->rows + solver->cols) * sizeof(uint64_t));
+    if (solver->pos_keys == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < solver->rows + solver->cols; i++) solver->pos_keys[i] = splitmix64(&seed);
+    for (int i = 0; i < 512; i++) solver->health_keys[i] = splitmix64(&seed);
+    for (int i = 0; i < 256; i++) solver->coin_keys[i] = splitmix64(&seed);
+    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) {
+        for (int j = 0; j < 128; j++) solver->item_keys[i][j] = splitmix64(&seed);
+    }
+    for (int i = 0; i < 3; i++) solver->flag_keys[i] = splitmix64(&seed);
+    for (int i = 0; i < TIMER_KIND_COUNT; i++) {
+        for (int j = 0; j < 256; j++) solver->timer_keys[i][j] = splitmix64(&seed);
+    }
+}
+
+static uint64_t solver_hash(Solver *solver, const SolverState *state, const char *snapshot) {
+    uint64_t key = solver->pos_keys[state->player_x] ^ solver->pos_keys[solver->rows + state->player_y] ^ solver->health_keys[(state->player_h + 256) & 511] ^
+        solver->coin_keys[state->coins & 255];
+
+    for (int i = 0; i < solver->snapshot_size; i++) key ^= solver->snapshot_keys[i * 256 + (unsigned char)snapshot[i]];
+    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) key ^= solver->item_keys[i][state->items[i] & 127];
+    if (state->weapon_flag) key ^= solver->flag_keys[0];
+    if (state->death_flag) key ^= solver->flag_keys[1];
+    if (state->spikes_raised) key ^= solver->flag_keys[2];
+    for (int i = 0; i < TIMER_KIND_COUNT; i++) key ^= solver->timer_keys[i][state->timers[i]];
+    return key;
+}
+
+static void solver_heuristic(Solver *solver, Arena *arena) { // 0-1 bfs from every exit, doors count as open and teleporters as free
+    int rows = solver->rows, cols = solver->cols, cells = rows * cols;
+    int *queue = (int *)game_malloc(2 * cells * sizeof(int)); // deque, 0-cost edges go to the front
+    int head = cells, tail = cells;
+    int *dist = solver->heuristic;
+
+    for (int i = 0; i < cells; i++) dist[i] = -1;
+    for (int exit = TILE_EXIT; exit <= TILE_EXIT_DOOR; exit++) {
+        long from = 0;
+        int i, j;
+        while (find_terrain(arena, exit, &from, &i, &j)) {
+            if (i < 1 || i >= rows - 1 || j < 1 || j >= cols - 1) continue;
+            dist[i * cols + j] = 0;
+            queue[tail++] = i * cols + j;
+        }
+    }
+
+    while (head < tail) {
+        int cell = queue[head++];
+        int row = cell / cols, col = cell % cols;
+
+        int tile = terrain_at(arena, row, col);
+        if (tile == TILE_LEFT_TELEPORTER || tile == TILE_RIGHT_TELEPORTER) { // standing on a teleporter = standing on its partner
+            int partner = tile == TILE_LEFT_TELEPORTER ? TILE_RIGHT_TELEPORTER : TILE_LEFT_TELEPORTER;
+            long from = 0;
+            int i, j;
+            while (find_terrain(arena, partner, &from, &i, &j)) {
+                if (i < 1 || i >= rows - 1 || j < 1 || j >= cols - 1) continue;
+                if (dist[i * cols + j] == -1 || dist[i * cols + j] > dist[cell]) {
+                    dist[i * cols + j] = dist[cell];
+                    queue[--head] = i * cols + j;
+                }
+            }
+        }
+
+        for (int d = 0; d < 4; d++) {
+            int new_row = row + row_dir[d];
+            int new_col = col + col_dir[d];
+            if (new_row >= 1 && new_row < rows - 1 && new_col >= 1 && new_col < cols - 1 &&
+                terrain_at(arena, new_row, new_col) != TILE_WALL && terrain_at(arena, new_row, new_col) != TILE_SIDE_WALL && dist[new_row * cols + new_col] == -1) {
+                dist[new_row * cols + new_col] = dist[cell] + 1;
+                queue[tail++] = new_row * cols + new_col;
+            }
+        }
+    }
+
+    game_free(queue);
+}
+
+static int solver_add(Solver *solver, const SolverState *state, const char *snapshot, int parent, int g, char move) {
+    int size = solver->snapshot_size;
+    uint64_t key = solver_hash(solver, state, snapshot);
+    int slot = (int)(key & solver->table_mask);
+
+    while (solver->table[slot] != -1) { // transposition ~ keep the shorter path
+        SolverNode *node = &solver->nodes[solver->table[slot]];
+        if (node->key == key && !memcmp(&node->state, state, sizeof(*state)) &&
+            !memcmp(solver->snapshots + (size_t)solver->table[slot] * size, snapshot, size)) {
+            if (g >= node->g) return -1;
+            node->g = g;
+            node->parent = parent;
+            node->move = move;
+            return solver->table[slot];
+        }
+        slot = (slot + 1) & solver->table_mask;
+    }
+
+    if (solver->count == SOLVER_MAX_STATES) return -2;
+    if (solver->count == solver->capacity) {
+        solver->capacity *= 2;
+        solver->nodes = (SolverNode *)game_realloc(solver->nodes, solver->capacity * sizeof(SolverNode));
+        solver->snapshots = (char *)game_realloc(solver->snapshots, (size_t)solver->capacity * size);
+        if (solver->nodes == NULL || solver->snapshots == NULL) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int index = solver->count++;
+    SolverNode *node = &solver->nodes[index];
+    memset(node, 0, sizeof(*node));
+    node->state = *state;
+    node->key = key;
+    node->parent = parent;
+    node->g = g;
+    node->move = move;
+    memcpy(solver->snapshots + (size_t)index * size, snapshot, size);
+    solver->table[slot] = index;
+    return index;
+}
+
+static int solver_entry_before(SolverEntry a, SolverEntry b) {
+    return a.f < b.f || (a.f == b.f && a.g > b.g);
+}
+
+static void solver_push(Solver *solver, SolverEntry entry) {
+    if (solver->heap_count == solver->heap_capacity) {
+        solver->heap_capacity *= 2;
+        solver->heap = (SolverEntry *)game_realloc(solver->heap, solver->heap_capacity * sizeof(SolverEntry));
+        if (solver->heap == NULL) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    int i = solver->heap_count++;
+    while (i > 0 && solver_entry_before(entry, solver->heap[(i - 1) / 2])) {
+        solver->heap[i] = solver->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    solver->heap[i] = entry;
+}
+
+static SolverEntry solver_pop(Solver *solver) {
+    SolverEntry top = solver->heap[0];
+    SolverEntry last = solver->heap[--solver->heap_count];
+    int i = 0;
+    while (2 * i + 1 < solver->heap_count) {
+        int child = 2 * i + 1;
+        if (child + 1 < solver->heap_count && solver_entry_before(solver->heap[child + 1], solver->heap[child])) child++;
+        if (!solver_entry_before(solver->heap[child], last)) break;
+        solver->heap[i] = solver->heap[child];
+        i = child;
+    }
+    solver->heap[i] = last;
+    return top;
+}
+
+static void solver_load_state(Arena *arena, const SolverState *state) { // the game rules work on the global player state
+    player_h = state->player_h;
+    weapon_flag = state->weapon_flag;
+    death_flag = state->death_flag;
+    coins = state->coins;
+    memcpy(items, state->items, sizeof(items));
+    arena->spikes_raised = state->spikes_raised;
+    arena->trigger_cell = state->player_x * arena->cols + state->player_y; // where the last tick left the player
+    for (int i = 0; i < TIMER_KIND_COUNT; i++) {
+        if (state->timers[i]) arena_schedule(arena, i, state->timers[i]);
+        else arena_cancel(arena, i);
+    }
+}
+
+static void solver_save_state(Arena *arena, SolverState *state, int player_x, int player_y) {
+    memset(state, 0, sizeof(*state));
+    state->player_x = player_x;
+    state->player_y = player_y;
+    state->player_h = player_h;
+    state->weapon_flag = weapon_flag;
+    state->death_flag = death_flag;
+    state->coins = coins;
+    memcpy(state->items, items, sizeof(items));
+    state->spikes_raised = arena->spikes_raised;
+    for (int i = 0; i < TIMER_KIND_COUNT; i++) state->timers[i] = timer_remaining(&arena->timers, arena->timer_of[i]); // every delay fits a byte
+}
+
+void solve_arena(const char *file_name, char *report, size_t report_len) {
+    int rows, cols;
+    Arena *arena;
+
+    get_arena_dimensions(file_name, &rows, &cols);
+    arena = create_arena(rows, cols);
+    initialize_arena(arena, rows, cols, file_name);
+    int player_x = arena->start_row, player_y = arena->start_col;
+
+    Solver solver = {0};
+    int cells = rows * cols;
+    int table_size = 1;
+    while (table_size < 2 * SOLVER_MAX_STATES) table_size *= 2;
+    solver.rows = rows;
+    solver.cols = cols;
+    solver.snapshot_size = arena_snapshot_size(arena);
+    solver.capacity = 1024;
+    solver.nodes = (SolverNode *)game_malloc(solver.capacity * sizeof(SolverNode));
+    solver.snapshots = (char *)game_malloc((size_t)solver.capacity * solver.snapshot_size);
+    solver.table = (int *)game_malloc(table_size * sizeof(int));
+    solver.table_mask = table_size - 1;
+    solver.heap_capacity = 1024;
+    solver.heap = (SolverEntry *)game_malloc(solver.heap_capacity * sizeof(SolverEntry));
+    solver.heuristic = (int *)game_malloc(cells * sizeof(int));
+    if (!solver.nodes || !solver.snapshots || !solver.table || !solver.heap || !solver.heuristic) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(solver.table, -1, table_size * sizeof(int));
+    solver_init_keys(&solver);
+    solver_heuristic(&solver, arena);
+
+    // start state = a fresh arena with a fresh player
+    char *snapshot = (char *)game_malloc(solver.snapshot_size);
+    SolverState start;
+    player_h = 100; weapon_flag = 0; death_flag = 0; coins = 0;
+    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
+    solver_save_state(arena, &start, player_x, player_y);
+    save_arena_snapshot(arena, snapshot);
+
+    int goal = -1;
+    int gave_up = 0;
+    int start_h = solver.heuristic[player_x * cols + player_y];
+    if (start_h != -1) solver_push(&solver, (SolverEntry){ start_h, 0, solver_add(&solver, &start, snapshot, -1, 0, 0) });
+
+    while (solver.heap_count && goal == -1 && !gave_up) { // A*
+        SolverEntry entry = solver_pop(&solver);
+        if (entry.g != solver.nodes[entry.node].g) continue; // stale entry, a shorter path was found meanwhile
+
+        for (int m = 0; SOLVER_MOVES[m]; m++) {
+            SolverState current = solver.nodes[entry.node].state;
+            char move = SOLVER_MOVES[m];
+            if (move >= '1' && move <= '3' && current.items[move - '1'] == '\0') continue; // empty slot ~ nothing happens
+
+            load_arena_snapshot(arena, solver.snapshots + (size_t)entry.node * solver.snapshot_size);
+            solver_load_state(arena, &current);
+            int x = current.player_x, y = current.player_y;
+
+            TickResult result = simulate_tick(arena, rows, cols, &x, &y, move);
+            if (result == TICK_SPIKE_DEATH || result == TICK_WARRIOR_DEATH || result == TICK_HOLE_DEATH) continue;
+
+            SolverState next;
+            solver_save_state(arena, &next, x, y);
+            save_arena_snapshot(arena, snapshot);
+
+            int h = result == TICK_ARENA_EXIT ? 0 : solver.heuristic[x * cols + y];
+            if (h == -1) continue; // the exit can never be reached from here
+
+            int index = solver_add(&solver, &next, snapshot, entry.node, entry.g + 1, move);
+            if (index == -2) { gave_up = 1; break; }
+            if (index == -1) continue;
+            if (result == TICK_ARENA_EXIT) { goal = index; break; } // unit costs + consistent heuristic ~ first exit is the shortest
+            solver_push(&solver, (SolverEntry){ entry.g + 1 + h, entry.g + 1, index });
+        }
+    }
+
+    if (goal != -1) {
+        int length = solver.nodes[goal].g;
+        char *moves = (char *)game_malloc(length + 1);
+        moves[length] = '\0';
+        for (int node = goal; solver.nodes[node].parent != -1; node = solver.nodes[node].parent) moves[--length] = solver.nodes[node].move;
+        snprintf(report, report_len, "%s: solved in %d moves (%d states): %s\n", file_name, solver.nodes[goal].g, solver.count, moves);
+        game_free(moves);
+    }
+    else if (gave_up) snprintf(report, report_len, "%s: unknown, gave up after %d states\n", file_name, solver.count);
+    else if (!count_terrain(arena, TILE_EXIT) && !count_terrain(arena, TILE_EXIT_DOOR)) snprintf(report, report_len, "%s: unsolvable, the arena has no exit\n", file_name);
+    else if (!solver.count) snprintf(report, report_len, "%s: unsolvable, no exit can be reached from the start\n", file_name);
+    else snprintf(report, report_len, "%s: unsolvable, all %d reachable states explored\n", file_name, solver.count);
+
+    game_free(snapshot);
+    game_free(solver.nodes);
+    game_free(solver.snapshots);
+    game_free(solver.table);
+    game_free(solver.heap);
+    game_free(solver.heuristic);
+    game_free(solver.snapshot_keys);
+    game_free(solver.pos_keys);
+    free_arena(arena);
+}
+
+static int compare_file_names(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+int run_solver(int count, char *files[]) {
+    char **pack = files;
+    int pack_count = count;
+
+    if (!count) { // no files given ~ validate the whole level pack
+        DIR *dir = opendir("pre_build_arenas");
+        if (!dir) {
+            perror("opendir");
+            return EXIT_FAILURE;
+        }
+        pack = NULL;
+        struct dirent *entry;
+        while ((entry = readdir(dir))) {
+            int length = strlen(entry->d_name);
+            if (length > 4 && !strcmp(entry->d_name + length - 4, ".txt")) {
+                pack = (char **)game_realloc(pack, (pack_count + 1) * sizeof(char *));
+                pack[pack_count++] = strdup(entry->d_name);
+            }
+        }
+        closedir(dir);
+        qsort(pack, pack_count, sizeof(char *), compare_file_names);
+    }
+
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1) workers = 1;
+
+    int (*pipes)[2] = game_malloc(pack_count * sizeof(*pipes));
+    int running = 0;
+    for (int i = 0; i < pack_count; i++) { // one process per arena, at most one per core at a time
+        if (running == workers) {
+            wait(NULL);
+            running--;
+        }
+        if (pipe(pipes[i]) == -1) {
+            perror("pipe");
+            return EXIT_FAILURE;
+        }
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (!pid) {
+            char report[MAX_LINE_LENGTH * 4];
+            close(pipes[i][0]);
+            solve_arena(pack[i], report, sizeof(report));
+            if (write(pipes[i][1], report, strlen(report)) == -1) _exit(EXIT_FAILURE);
+            _exit(EXIT_SUCCESS);
+        }
+        close(pipes[i][1]);
+        running++;
+    }
+    while (wait(NULL) > 0);
+
+    int unsolved = 0;
+    for (int i = 0; i < pack_count; i++) { // reports come back in pack order
+        char report[MAX_LINE_LENGTH * 4];
+        ssize_t length = read(pipes[i][0], report, sizeof(report) - 1);
+        close(pipes[i][0]);
+        if (length <= 0) {
+            printf("%s: solver crashed\n", pack[i]);
+            unsolved++;
+            continue;
+        }
+        report[length] = '\0';
+        if (!strstr(report, "solved in")) unsolved++;
+        fputs(report, stdout);
+    }
+
+    game_free(pipes);
+    if (pack != files) {
+        for (int i = 0; i < pack_count; i++) free(pack[i]);
+        game_free(pack);
+    }
+    return unsolved ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/*
+    BUILDING (terrain writes through a journal: undo, redo, checkpoints, dirty regions & deltas)
+*/
+void journal_init(Journal *journal, BumpAllocator *memory) {
+    journal->capacity = JOURNAL_FIRST_ENTRIES;
+    journal->entries = (uint64_t *)bump_alloc(memory, journal->capacity * sizeof(uint64_t));
+    journal->mark_capacity = JOURNAL_FIRST_ENTRIES;
+    journal->marks = (int *)bump_alloc(memory, journal->mark_capacity * sizeof(int));
+    journal->marks[0] = 0;
+    journal->mark_count = journal->mark_end = 1;
+    journal->count = journal->end = 0;
+    journal->dirty_top = journal->dirty_left = INT32_MAX;
+    journal->dirty_bottom = journal->dirty_right = -1;
+}
+
+static void journal_grow(Journal *journal, BumpAllocator *memory, int entries, int marks) { // the old arrays stay in the level memory until the level is freed
+    if (journal->end + entries > journal->capacity) {
+        int capacity = 2 * journal->capacity > journal->end + entries ? 2 * journal->capacity : journal->end + entries;
+        uint64_t *bigger = (uint64_t *)bump_alloc(memory, capacity * sizeof(uint64_t));
+        memcpy(bigger, journal->entries, journal->end * sizeof(uint64_t)); // the ones that can be redone too
+        journal->entries = bigger;
+        journal->capacity = capacity;
+    }
+    if (journal->mark_end + marks > journal->mark_capacity) {
+        int capacity = 2 * journal->mark_capacity > journal->mark_end + marks ? 2 * journal->mark_capacity : journal->mark_end + marks;
+        int *bigger = (int *)bump_alloc(memory, capacity * sizeof(int));
+        memcpy(bigger, journal->marks, journal->mark_end * sizeof(int));
+        journal->marks = bigger;
+        journal->mark_capacity = capacity;
+    }
+}
+
+void journal_reserve(Arena *arena) { // between ticks, so TA_ALLOC_CHECK never sees building grow the journal
+    journal_grow(&arena->journal, &arena->memory, JOURNAL_TICK_ENTRIES, JOURNAL_TICK_ENTRIES);
+}
+
+static void journal_apply(Arena *arena, int cell, int tile) {
+    Journal *journal = &arena->journal;
+    int row = cell / arena->cols, col = cell % arena->cols;
+    set_terrain(arena, row, col, tile); // vision, passability, boss paths & the state hash follow
+    if (row < journal->dirty_top) journal->dirty_top = row;
+    if (row > journal->dirty_bottom) journal->dirty_bottom = row;
+    if (col < journal->dirty_left) journal->dirty_left = col;
+    if (col > journal->dirty_right) journal->dirty_right = col;
+}
+
+void journal_set(Arena *arena, int row, int col, int tile) {
+    Journal *journal = &arena->journal;
+    int old = terrain_at(arena, row, col);
+    if (old == tile) return;
+
+    journal->end = journal->count; // a new change ends what could be redone
+    journal->mark_end = journal->mark_count;
+    journal_grow(journal, &arena->memory, 1, 0); // only deltas get here full, journal_reserve ran before the tick
+    journal->entries[journal->count++] = (uint64_t)(row * arena->cols + col) << 8 | old << 4 | tile;
+    journal->end = journal->count;
+    journal_apply(arena, row * arena->cols + col, tile);
+}
+
+int journal_checkpoint(Arena *arena) {
+    Journal *journal = &arena->journal;
+    if (journal->marks[journal->mark_count - 1] == journal->count) return journal->mark_count - 1; // nothing changed since
+    journal->mark_end = journal->mark_count; // a new checkpoint ends what could be redone
+    journal_grow(journal, &arena->memory, 0, 1);
+    journal->marks[journal->mark_count++] = journal->count;
+    journal->mark_end = journal->mark_count;
+    return journal->mark_count - 1;
+}
+
+int journal_undo(Arena *arena) {
+    Journal *journal = &arena->journal;
+    journal_checkpoint(arena); // changes since the last checkpoint are a step of their own
+    if (journal->mark_count == 1) return 0;
+    int target = journal->marks[--journal->mark_count - 1];
+    while (journal->count > target) {
+        uint64_t entry = journal->entries[--journal->count];
+        journal_apply(arena, entry >> 8, entry >> 4 & 0x0F);
+    }
+    return 1;
+}
+
+int journal_redo(Arena *arena) {
+    Journal *journal = &arena->journal;
+    if (journal->mark_count == journal->mark_end) return 0;
+    int target = journal->marks[journal->mark_count++];
+    while (journal->count < target) {
+        uint64_t entry = journal->entries[journal->count++];
+        journal_apply(arena, entry >> 8, entry & 0x0F);
+    }
+    return 1;
+}
+
+void journal_rewind(Arena *arena, int checkpoint) {
+    journal_checkpoint(arena);
+    while (arena->journal.mark_count - 1 > checkpoint) journal_undo(arena);
+}
+
+int journal_take_dirty(Arena *arena, int *top, int *left, int *bottom, int *right) {
+    Journal *journal = &arena->journal;
+    if (journal->dirty_top > journal->dirty_bottom) return 0;
+    *top = journal->dirty_top;
+    *left = journal->dirty_left;
+    *bottom = journal->dirty_bottom;
+    *right = journal->dirty_right;
+    journal->dirty_top = journal->dirty_left = INT32_MAX;
+    journal->dirty_bottom = journal->dirty_right = -1;
+    return 1;
+}
+
+long journal_save(Arena *arena, const char *path) {
+    Journal *journal = &arena->journal;
+    BumpAllocator scratch;
+    bump_init(&scratch, 4 * 16 * (sizeof(int) + 1));
+    CellMap last; // newest tile of every changed cell (| 0x10, so empty tiles are not '\0')
+    cellmap_init(&last, &scratch, NULL);
+    for (int i = journal->count - 1; i >= 0; i--) {
+        int cell = journal->entries[i] >> 8;
+        if (!cellmap_get(&last, cell)) cellmap_put(&last, cell, 0x10 | (journal->entries[i] & 0x0F));
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        bump_release(&scratch);
+        return -1;
+    }
+    JournalHeader header = { JOURNAL_MAGIC, arena->rows, arena->cols, 0, 0 };
+    fwrite(&header, sizeof(header), 1, fp);
+    int previous = 0;
+    for (int i = 0; i < journal->count; i++) { // first change of a cell holds the tile of the arena file, repeats are folded
+        int cell = journal->entries[i] >> 8, old = journal->entries[i] >> 4 & 0x0F;
+        char newest = cellmap_get(&last, cell);
+        if (!newest) continue;
+        cellmap_remove(&last, cell);
+        if ((newest & 0x0F) == old) continue; // changed back
+        long step = cell - previous;
+        rle_write_count(fp, step < 0 ? -2 * step - 1 : 2 * step); // zigzag
+        putc(old << 4 | (newest & 0x0F), fp);
+        previous = cell;
+        header.count++;
+    }
+    rewind(fp);
+    fwrite(&header, sizeof(header), 1, fp); // with the count
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    bump_release(&scratch);
+    return fclose(fp) ? -1 : size;
+}
+
+int journal_load(Arena *arena, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    JournalHeader header;
+    int before = journal_checkpoint(arena);
+    int ok = fread(&header, sizeof(header), 1, fp) == 1 && !memcmp(header.magic, JOURNAL_MAGIC, 8) && header.rows == arena->rows && header.cols == arena->cols;
+    long cell = 0;
+    for (int i = 0; ok && i < header.count; i++) {
+        long step = rle_read_count(fp);
+        int tiles = getc(fp);
+        if (step < 0 || tiles == EOF) ok = 0;
+        else {
+            cell += step & 1 ? -(step + 1) / 2 : step / 2;
+            if (cell < 0 || cell >= (long)arena->rows * arena->cols || terrain_at(arena, cell / arena->cols, cell % arena->cols) != tiles >> 4) ok = 0; // made for another arena
+            else journal_set(arena, cell / arena->cols, cell % arena->cols, tiles & 0x0F);
+        }
+    }
+    fclose(fp);
+    if (ok) journal_checkpoint(arena); // undo takes the whole delta back at once
+    else journal_rewind(arena, before);
+    return ok;
+}
+
+int build_wall(Arena *arena, int player_x, int player_y) {
+    int row = player_x + row_dir[facing], col = player_y + col_dir[facing];
+    if (row < 1 || row >= arena->rows - 1 || col < 1 || col >= arena->cols - 1) return 0; // the border is not built on
+    if (terrain_at(arena, row, col) != TILE_EMPTY || arena_tile(arena, row, col) != ' ') return 0; // items, warriors & bosses too
+
+    journal_set(arena, row, col, TILE_WALL);
+    journal_checkpoint(arena); // one build = one undo step
+    return 1;
+}
+
+int run_apply_delta(int count, char *args[]) {
+    if (count != 2) {
+        fprintf(stderr, "usage: --apply-delta <arena file> <delta file> ~ prints the arena with the building delta on top\n");
+        return EXIT_FAILURE;
+    }
+    int rows, cols;
+    get_arena_dimensions(args[0], &rows, &cols);
+    Arena *arena = create_arena(rows, cols);
+    initialize_arena(arena, rows, cols, args[0]);
+    if (!journal_load(arena, args[1])) {
+        fprintf(stderr, "%s: not a delta of %s\n", args[1], args[0]);
+        free_arena(arena);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) putchar(i == arena->start_row && j == arena->start_col ? 'p' : arena_tile(arena, i, j));
+        putchar('\n');
+    }
+    free_arena(arena);
+    return EXIT_SUCCESS;
+}
+
+/*
+    HOT RELOAD (TA_HOT_RELOAD=1 ./version1 ~ saved arena files are patched into the running level, Linux only)
+*/
+#ifdef __linux__
+void hot_reload_init() {
+    const char *env = getenv("TA_HOT_RELOAD");
+    if (!env || !*env || !strcmp(env, "0")) return;
+    hot_reload.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (hot_reload.fd == -1) {
+        perror("inotify_init1"); // the game runs without hot reload
+        return;
+    }
+    setvbuf(stdin, NULL, _IONBF, 0); // every key is read on its own, so poll() sees whatever is still pending
+}
+
+static char *hot_reload_read(const char *path, long *length) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    char *text = NULL;
+    size_t capacity = 0;
+    *length = 0;
+    for (size_t got; ; *length += got) {
+        if ((size_t)*length + 4096 > capacity) {
+            capacity = capacity ? 2 * capacity : 65536;
+            text = (char *)game_realloc(text, capacity + 1);
+            if (text == NULL) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (!(got = fread(text + *length, 1, capacity - *length, fp))) break;
+    }
+    text[*length] = '\0';
+    fclose(fp);
+    return text;
+}
+
+static void hot_reload_track(const char *path) { // the arena in play changed ~ remember its text & watch its directory
+    char dir[MAX_PATH_LENGTH];
+    const char *slash = strrchr(path, '/');
+    snprintf(dir, sizeof(dir), "%.*s", slash ? (int)(slash - path) : 1, slash ? path : ".");
+    if (hot_reload.watch == -1 || strcmp(dir, hot_reload.dir)) {
+        if (hot_reload.watch != -1) inotify_rm_watch(hot_reload.fd, hot_reload.watch);
+        hot_reload.watch = inotify_add_watch(hot_reload.fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO); // editors write in place or rename over
+        snprintf(hot_reload.dir, sizeof(hot_reload.dir), "%s", dir);
+    }
+    snprintf(hot_reload.path, sizeof(hot_reload.path), "%s", path);
+    game_free(hot_reload.text);
+    hot_reload.text = hot_reload_read(path, &hot_reload.length);
+}
+
+static void hot_reload_put(Arena *arena, int row, int col, char glyph, int player_x, int player_y) { // the terrain follows the file, whatever lives on the tile stays
+    int cell = row * arena->cols + col;
+    const char *tile = strchr(TILE_GLYPHS, glyph);
+    int occupied = (row == player_x && col == player_y) || cellmap_get(&arena->warriors, cell) || cellmap_get(&arena->items, cell) ||
+        (arena->boss_count && boss_at(arena, row, col) != -1);
+
+    if (glyph != 'p' && glyph != 'w' && glyph != '&' && !strchr(ITEM_GLYPHS, glyph)) { // terrain or a label
+        cellmap_remove(&arena->labels, cell);
+        if (!tile) cellmap_put(&arena->labels, cell, glyph);
+        set_terrain(arena, row, col, tile ? tile - TILE_GLYPHS : TILE_LABEL);
+    }
+    else if (glyph == 'p' || occupied) { // an entity stands on empty ground, a new one only comes on a free tile
+        if (glyph == 'p') {
+            arena->start_row = row;
+            arena->start_col = col;
+        }
+        cellmap_remove(&arena->labels, cell);
+        set_terrain(arena, row, col, TILE_EMPTY);
+    }
+    else arena_put(arena, row, col, glyph);
+}
+
+static int hot_reload_patch(Arena *arena, const char *text, long length, int player_x, int player_y) { // only lines that differ are parsed, 0 = the size changed
+    const char *old = hot_reload.text, *old_end = old + hot_reload.length;
+    const char *now = text, *now_end = text + length;
+    int rows = 0, cols = 0;
+    for (const char *line = now; line < now_end; rows++) { // same size rules as get_arena_dimensions
+        const char *end = memchr(line, '\n', now_end - line);
+        if (!end) end = now_end;
+        if (end - line > cols) cols = end - line;
+        line = end + 1;
+    }
+    if (rows != arena->rows || cols != arena->cols) return 0;
+
+    for (int i = 0; i < rows; i++) {
+        const char *old_line_end = old < old_end ? memchr(old, '\n', old_end - old) : NULL;
+        const char *now_line_end = memchr(now, '\n', now_end - now);
+        if (!old_line_end) old_line_end = old < old_end ? old_end : old;
+        if (!now_line_end) now_line_end = now_end;
+        long old_length = old_line_end - old, now_length = now_line_end - now;
+
+        if (old_length != now_length || memcmp(old, now, now_length)) {
+            for (int j = 0; j < cols; j++) {
+                char was = j < old_length ? old[j] : ' ', glyph = j < now_length ? now[j] : ' ';
+                if (was == glyph) continue; // whatever happened to the tile in play stays
+                hot_reload_put(arena, i, j, glyph, player_x, player_y);
+            }
+        }
+        old = old_line_end < old_end ? old_line_end + 1 : old_end;
+        now = now_line_end + 1;
+    }
+
+    // caches that set_terrain does not keep up with: timers that may now have something to do
+    if (arena->warriors.count && arena->timer_of[TIMER_FIGHTERS] == -1) arena_schedule(arena, TIMER_FIGHTERS, WARRIOR_CADENCE);
+    if (count_terrain(arena, TILE_TIMED_SPIKE) && arena->timer_of[TIMER_SPIKES] == -1) arena_schedule(arena, TIMER_SPIKES, SPIKE_TICKS);
+    if (arena->boss_count && arena->timer_of[TIMER_BOSSES] == -1) arena_schedule(arena, TIMER_BOSSES, BOSS_CADENCE);
+    return 1;
+}
+
+int hot_reload_wait(Arena **arena, int *rows, int *cols, int *player_x, int *player_y) {
+    char path[MAX_PATH_LENGTH];
+    arena_path(arena_files[current_arena], path);
+    if (strcmp(path, hot_reload.path)) hot_reload_track(path); // a new level was loaded since
+
+    struct pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { hot_reload.fd, POLLIN, 0 } };
+    while (1) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) continue; // window resized
+            return 0;
+        }
+        if (fds[0].revents) return 0; // the key is read as usual
+
+        char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        char triggers[MAX_PATH_LENGTH];
+        const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+        const char *triggers_name = NULL; // edits of <arena>.triggers reload the triggers
+        if (triggers_path(arena_files[current_arena], triggers)) triggers_name = strrchr(triggers, '/') ? strrchr(triggers, '/') + 1 : triggers;
+        int changed = 0, triggers_changed = 0;
+        ssize_t size;
+        while ((size = read(hot_reload.fd, events, sizeof(events))) > 0) {
+            for (char *at = events; at < events + size; at += sizeof(struct inotify_event) + ((struct inotify_event *)at)->len) {
+                struct inotify_event *event = (struct inotify_event *)at;
+                if (event->len && !strcmp(event->name, name)) changed = 1;
+                if (event->len && triggers_name && !strcmp(event->name, triggers_name)) triggers_changed = 1;
+            }
+        }
+        if (!changed && !triggers_changed) continue;
+
+        ProfileScope start = PROFILE_BEGIN();
+        long length = 0;
+        char *text = changed ? hot_reload_read(path, &length) : NULL;
+        if (changed && !text && !triggers_changed) continue; // removed, the level in play stays
+        RleHeader header;
+        int compressed = text && (size_t)length >= sizeof(header) && !memcmp(text, RLE_MAGIC, 8);
+        if (text && (compressed || !hot_reload.text || !hot_reload_patch(*arena, text, length, *player_x, *player_y))) { // new size ~ load it whole, triggers too
+            free_arena(*arena);
+            get_arena_dimensions(arena_files[current_arena], rows, cols);
+            *arena = create_arena(*rows, *cols);
+            initialize_arena(*arena, *rows, *cols, arena_files[current_arena]);
+        }
+        else { // the patched arena keeps its memory, the triggers are read again on top
+            triggers_load(*arena, arena_files[current_arena]);
+            (*arena)->trigger_cell = *player_x * *cols + *player_y; // no enter or exit for where the player already is
+        }
+        if (text) {
+            game_free(hot_reload.text);
+            hot_reload.text = text;
+            hot_reload.length = length;
+        }
+
+        int x = *player_x, y = *player_y; // stays where it was unless that is no longer a place to stand
+        if (x < 1 || x >= *rows - 1 || y < 1 || y >= *cols - 1 || strchr("=|Dd", arena_tile(*arena, x, y)) || ((*arena)->boss_count && boss_at(*arena, x, y) != -1)) {
+            *player_x = (*arena)->start_row;
+            *player_y = (*arena)->start_col;
+        }
+        PROFILE_END(PHASE_LOAD, start);
+        return 1;
+    }
+}
+#else
+void hot_reload_init() { // no inotify, hot_reload.fd stays -1
+    const char *env = getenv("TA_HOT_RELOAD");
+    if (env && *env && strcmp(env, "0")) fprintf(stderr, "TA_HOT_RELOAD: hot reload needs inotify (Linux), the game runs without it\n");
+}
+
+int hot_reload_wait(Arena **arena, int *rows, int *cols, int *player_x, int *player_y) {
+    return 0;
+}
+#endif
+
+/*
+    RENDER THREAD (TA_RENDER_THREAD=1 ./version1 ~ a slow terminal no longer holds up the game, Linux only)
+*/
+#ifdef __linux__
+static ssize_t render_compose(void *cookie, const char *buffer, size_t size) { // stdout between render_begin & render_submit
+    RenderFrame *frame = &render.frames[render.back];
+    if (frame->length + size > frame->capacity) {
+        size_t capacity = frame->capacity ? frame->capacity : BUFSIZ;
+        while (capacity < frame->length + size) capacity *= 2;
+        char *data = (char *)game_realloc(frame->data, capacity);
+        if (data == NULL) {
+            stdout = render.terminal; // exit flushes stdout, which must not come back here
+            render.enabled = 0;
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        frame->data = data;
+        frame->capacity = capacity;
+    }
+    memcpy(frame->data + frame->length, buffer, size);
+    frame->length += size;
+    PROFILE_COUNT(COUNTER_BYTES_WRITTEN, size);
+    return size;
+}
+
+static void *render_writer(void *unused) {
+    for (;;) {
+        sem_wait(&render.ready);
+        if (!(atomic_load(&render.middle) & RENDER_FRESH)) continue; // taken already, frames submitted since the last wake are dropped
+        render.front = atomic_exchange(&render.middle, render.front) & ~RENDER_FRESH;
+
+        RenderFrame *frame = &render.frames[render.front];
+        for (size_t done = 0; done < frame->length;) {
+            ssize_t written = write(STDOUT_FILENO, frame->data + done, frame->length - done);
+            if (written == -1 && errno == EINTR) continue;
+            if (written == -1) { // exit() belongs to the game thread, it may be composing a frame into stdout right now
+                atomic_store(&render.error, errno);
+                return unused;
+            }
+            done += written;
+        }
+        atomic_store(&render.written, frame->sequence);
+    }
+}
+
+static void render_check() { // the render thread stopped on a write error ~ exit from the game thread, with stdout back on the terminal
+    int error = atomic_load(&render.error);
+    if (!error) return;
+    if (stdout == render.stream) stdout = render.terminal;
+    render.enabled = 0; // nothing left to drain
+    errno = error;
+    perror("Error writing frame");
+    exit(EXIT_FAILURE);
+}
+
+void render_init() {
+    const char *env = getenv("TA_RENDER_THREAD");
+    if (!env || !*env || !strcmp(env, "0")) return;
+
+    render.stream = write_stream(render_compose);
+    if (render.stream == NULL) return;
+    setvbuf(render.stream, NULL, _IOFBF, BUFSIZ);
+    render.back = 0;
+    render.front = 1;
+    atomic_store(&render.middle, 2);
+    sem_init(&render.ready, 0, 0);
+
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old); // signals stay with the game thread
+    int failed = pthread_create(&render.writer, NULL, render_writer, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (failed) {
+        fclose(render.stream);
+        return;
+    }
+    render.enabled = 1;
+}
+
+void render_begin() {
+    if (!render.enabled) return;
+    render_check();
+    if (__fpending(stdout)) { // printed outside a frame (a clear after a screen), it goes out before the frames that follow
+        render_drain();
+        fflush(stdout);
+    }
+    render.frames[render.back].length = 0;
+    render.terminal = stdout;
+    stdout = render.stream;
+}
+
+void render_submit() {
+    if (!render.enabled) return;
+    fflush(render.stream);
+    stdout = render.terminal;
+    render.frames[render.back].sequence = ++render.submitted;
+    int old = atomic_exchange(&render.middle, render.back | RENDER_FRESH);
+    if (old & RENDER_FRESH) PROFILE_COUNT(COUNTER_FRAMES_DROPPED, 1); // the terminal is behind, that frame is never written
+    render.back = old & ~RENDER_FRESH;
+    sem_post(&render.ready);
+    render_check();
+}
+
+void render_drain() {
+    if (!render.enabled) return;
+    while (atomic_load(&render.written) != render.submitted) {
+        render_check();
+        nanosleep(&(struct timespec){ 0, 100000 }, NULL);
+    }
+}
+#else
+void render_init() { // frames are written by the game thread, as without TA_RENDER_THREAD
+    const char *env = getenv("TA_RENDER_THREAD");
+    if (env && *env && strcmp(env, "0")) fprintf(stderr, "TA_RENDER_THREAD: the render thread needs Linux, frames are written directly\n");
+}
+
+void render_begin() {}
+void render_submit() {}
+void render_drain() {}
+#endif
+
+/*
+    BATCH REPLAYS (./version1 --batch <script dir> [arena files] ~ JSON on stdout)
+*/
+#define BATCH_MAX_ARENAS 64
+
+typedef enum {
+    OUTCOME_WON,            // every arena of the list was cleared
+    OUTCOME_SPIKE_DEATH,
+    OUTCOME_HOLE_DEATH,
+    OUTCOME_WARRIOR_DEATH,
+    OUTCOME_OUT_OF_INPUTS,  // the script ended first
+    OUTCOME_UNREADABLE,     // the script could not be read
+    OUTCOME_CRASHED,        // the worker running it died
+    OUTCOME_COUNT
+} BatchOutcome;
+
+const char *OUTCOME_NAMES[OUTCOME_COUNT] = {"won", "spike_death", "hole_death", "warrior_death", "out_of_inputs", "unreadable", "crashed"};
+
+typedef struct {
+    int outcome;
+    int score, coins;
+    int arena;      // index of the arena the run ended in (= the arena count when it was won)
+    long ticks;
+} BatchResult;
+
+typedef struct { // shared by the workers, lives in an anonymous shared mapping
+    atomic_long next;       // next script nobody has claimed yet
+    BatchResult results[];  // one per script, written by whichever worker ran it
+} BatchQueue;
+
+static char *batch_read_script(const char *path, long *length) { // the inputs of a text script or of a telemetry log
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    char *inputs = NULL;
+    long capacity = 0;
+    *length = 0;
+    char magic[8];
+    int recorded = fread(magic, 1, 8, fp) == 8 && !memcmp(magic, TELEMETRY_MAGIC, 8); // recorded session ~ replay its key presses
+    if (!recorded) rewind(fp);
+
+    TelemetryRecord record;
+    int c;
+    while (recorded ? fread(&record, sizeof(record), 1, fp) == 1 : (c = fgetc(fp)) != EOF) {
+        if (recorded) {
+            if (record.type != EVENT_INPUT) continue;
+            c = record.value;
+        }
+        if (!recorded && (!c || !strchr(GAME_INPUTS "WASDBZY", c))) continue; // whitespace & comments, every recorded key was a tick of its own
+        if (*length == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            inputs = (char *)game_realloc(inputs, capacity);
+            if (inputs == NULL) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+        }
+        inputs[(*length)++] = c;
+    }
+
+    fclose(fp);
+    return inputs ? inputs : (char *)game_malloc(1);
+}
+
+static void batch_run(const char *path, char **arenas, int arena_count, BatchResult *result) { // one session, like start_game without a screen
+    long length;
+    char *inputs = batch_read_script(path, &length);
+    memset(result, 0, sizeof(*result));
+    if (!inputs) {
+        result->outcome = OUTCOME_UNREADABLE;
+        return;
+    }
+    const char *trace_dir = getenv("TA_TRACE");
+    if (trace_dir && *trace_dir) { // one trace per script, named after it
+        char trace_path[MAX_PATH_LENGTH];
+        snprintf(trace_path, sizeof(trace_path), "%s/%s.trace", trace_dir, strrchr(path, '/') + 1);
+        if (!trace_open(trace_path)) perror(trace_path);
+    }
+
+    int rows, cols;
+    int current = 0;
+    Arena *arena = NULL;
+    int player_x = 0, player_y = 0;
+    player_h = 100; coins = 0; score = 0; death_flag = 0; weapon_flag = 0;
+    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
+    result->outcome = OUTCOME_OUT_OF_INPUTS;
+
+    long next = 0; // input of the next tick
+    while (1) {
+        if (!arena) { // (re)load the current arena
+            get_arena_dimensions(arenas[current], &rows, &cols);
+            arena = create_arena(rows, cols);
+            initialize_arena(arena, rows, cols, arenas[current]);
+            player_x = arena->start_row;
+            player_y = arena->start_col;
+        }
+        if (!death_flag && next == length) break;
+
+        TickResult tick_result = simulate_tick(arena, rows, cols, &player_x, &player_y, death_flag ? '\0' : inputs[next++]); // like start_game, a dead player's tick reads no key
+        TRACE_TICK(arena, player_x, player_y);
+        result->ticks++;
+
+        const char *name = strrchr(arenas[current], '/') ? strrchr(arenas[current], '/') + 1 : arenas[current];
+        if ((tick_result == TICK_SPIKE_DEATH || tick_result == TICK_WARRIOR_DEATH || tick_result == TICK_HOLE_DEATH) && !strstr(name, "welcome")) { // the game lets the player walk on in the welcome arena, over holes too
+            free_arena(arena);
+            arena = NULL;
+            death_flag = 0; weapon_flag = 0;
+            if (strstr(name, "tutorial")) { // tutorials restart, like in the game
+                player_h = 100; coins = 0; score = 0;
+                for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
+                continue;
+            }
+            result->outcome = tick_result == TICK_SPIKE_DEATH ? OUTCOME_SPIKE_DEATH : tick_result == TICK_HOLE_DEATH ? OUTCOME_HOLE_DEATH : OUTCOME_WARRIOR_DEATH;
+            break;
+        }
+
+        if (tick_result == TICK_ARENA_EXIT) {
+            score += 200;
+            free_arena(arena);
+            arena = NULL;
+            death_flag = 0; weapon_flag = 0;
+            if (++current == arena_count) {
+                result->outcome = OUTCOME_WON;
+                break;
+            }
+            if (strstr(arenas[current], "tutorial") || strstr(arenas[current], "welcome")) {
+                player_h = 100; coins = 0; score = 0;
+                for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
+            }
+        }
     }
+
+    if (arena) free_arena(arena);
+    game_free(inputs);
+    trace_close();
+    result->score = score;
+    result->coins = coins;
+    result->arena = current;
 }
 
-void handle_consumable(char consumable, int *flag, int player_x, int player_y, char **arena) {
-    if (arena[player_x][player_y] == consumable) {
-        if (!is_inventory_full(items)) { // if the inventory is not full, add the item
-            for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) {
-                if (items[i] == '\0') {
-                    items[i] = consumable;
-                    break;
-                }
+int run_batch(int count, char *args[]) {
+    char *default_arenas[] = { "welcome.txt", "arena0.txt", "arena1.txt", "arena2.txt" }; // the game without the tutorial
+    if (count < 1 || count - 1 > BATCH_MAX_ARENAS) {
+        fprintf(stderr, "usage: --batch <script dir> [arena files]\n");
+        return EXIT_FAILURE;
+    }
+    char **arenas = count > 1 ? args + 1 : default_arenas;
+    int arena_count = count > 1 ? count - 1 : (int)(sizeof(default_arenas) / sizeof(default_arenas[0]));
+    for (int i = 0; i < arena_count; i++) {
+        char path[MAX_PATH_LENGTH];
+        arena_path(arenas[i], path);
+        if (access(path, R_OK)) {
+            perror(path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    DIR *dir = opendir(args[0]);
+    if (!dir) {
+        perror("opendir");
+        return EXIT_FAILURE;
+    }
+    char **scripts = NULL;
+    long script_count = 0, script_capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] == '.') continue;
+        if (script_count == script_capacity) {
+            script_capacity = script_capacity ? script_capacity * 2 : 64;
+            scripts = (char **)game_realloc(scripts, script_capacity * sizeof(char *));
+            if (scripts == NULL) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
             }
-        } 
-        else *flag = 1; // inventory is full ~ activate flag to let the item on the ground
+        }
+        scripts[script_count++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+    if (script_count) qsort(scripts, script_count, sizeof(char *), compare_file_names);
+
+    size_t queue_size = sizeof(BatchQueue) + (script_count + 1) * sizeof(BatchResult);
+    BatchQueue *queue = (BatchQueue *)mmap(NULL, queue_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (queue == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    atomic_init(&queue->next, 0);
+    for (long i = 0; i < script_count; i++) queue->results[i].outcome = OUTCOME_CRASHED; // until a worker finishes it
+
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1) workers = 1;
+    if (workers > script_count) workers = script_count;
+
+    // the rules work on the global player state, so the workers are processes; each one claims the next unclaimed script
+    // whenever it is free, so long scripts never hold up a core while others still wait
+    uint64_t start = monotonic_ns();
+    for (long w = 0; w < workers; w++) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (!pid) {
+            long index;
+            char path[MAX_PATH_LENGTH];
+            while ((index = atomic_fetch_add(&queue->next, 1)) < script_count) {
+                snprintf(path, sizeof(path), "%s/%s", args[0], scripts[index]);
+                batch_run(path, arenas, arena_count, &queue->results[index]);
+            }
+            _exit(EXIT_SUCCESS);
+        }
+    }
+    int crashed = 0;
+    int status;
+    while (wait(&status) > 0) if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) crashed++;
+    double seconds = (monotonic_ns() - start) / 1e9;
+
+    long outcomes[OUTCOME_COUNT] = {0};
+    long reached[BATCH_MAX_ARENAS + 1] = {0};
+    long long total_score = 0, total_coins = 0, total_ticks = 0;
+    int best_score = 0;
+    for (long i = 0; i < script_count; i++) {
+        const BatchResult *result = &queue->results[i];
+        outcomes[result->outcome]++;
+        reached[result->arena]++;
+        total_score += result->score;
+        total_coins += result->coins;
+        total_ticks += result->ticks;
+        if (result->score > best_score) best_score = result->score;
     }
-}
 
-void update_arena_character(char character, int *flag, int player_x, int player_y, char **arena) {
-    if(*flag) {
-        arena[player_x][player_y] = character;
-        *flag = 0;
+    long runs = script_count ? script_count : 1;
+    printf("{\n  \"scripts\": %ld, \"workers\": %ld, \"seconds\": %.3f, \"ticks_per_second\": %.0f,\n", script_count, workers, seconds, seconds > 0 ? total_ticks / seconds : 0.0);
+    printf("  \"mean_score\": %.1f, \"best_score\": %d, \"mean_coins\": %.2f, \"mean_ticks\": %.1f,\n", (double)total_score / runs, best_score, (double)total_coins / runs, (double)total_ticks / runs);
+    printf("  \"outcomes\": {");
+    for (int o = 0; o < OUTCOME_COUNT; o++) printf("%s\"%s\": %ld", o ? ", " : "", OUTCOME_NAMES[o], outcomes[o]);
+    printf("},\n  \"arena_reached\": {");
+    for (int a = 0; a <= arena_count; a++) printf("%s\"%s\": %ld", a ? ", " : "", a < arena_count ? arenas[a] : "won", reached[a]);
+    printf("},\n  \"runs\": [\n");
+    for (long i = 0; i < script_count; i++) {
+        const BatchResult *result = &queue->results[i];
+        printf("    {\"script\": \"%s\", \"outcome\": \"%s\", \"arena\": \"%s\", \"score\": %d, \"coins\": %d, \"ticks\": %ld}%s\n",
+            scripts[i], OUTCOME_NAMES[result->outcome], result->arena < arena_count ? arenas[result->arena] : "won", result->score, result->coins, result->ticks, i + 1 < script_count ? "," : "");
     }
+    printf("  ]\n}\n");
+
+    munmap(queue, queue_size);
+    for (long i = 0; i < script_count; i++) free(scripts[i]);
+    game_free(scripts);
+    if (crashed) fprintf(stderr, "%d batch workers crashed\n", crashed);
+    return crashed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
+
 /*
-    RESET FUNCTIONS
+    STATE TRACE (per-tick hashes for determinism checks: TA_TRACE=<file> ./version1, ./version1 --trace-diff <a> <b>)
 */
-void reset_current_arena(char ***arena, int *rows, int *cols, int *player_x, int *player_y) {
-    player_h = 100;
-    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
-    coins = 0;
-    score = 0;
+static uint64_t mix64(uint64_t z) { // splitmix64 finalizer, the same keys in every build & run
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
 
-    free_arena(*arena, *rows); 
-    initialize_game(arena, rows, cols, player_x, player_y);
+uint64_t state_key(int cell, int value) {
+    return mix64(((uint64_t)(uint32_t)cell << 8 | (unsigned char)value) * 0x9E3779B97F4A7C15ULL);
 }
 
-void reset_flags(int *over_spike, int *exit_game, int *death_flag, int *weapon_flag,
-                int *over_health_consumable, int *over_attack_consumable, int *over_info, int *over_small_hole) {
-    *over_spike = 0;
-    *exit_game = 0;
-    *death_flag = 0;
-    *weapon_flag = 0;
-    *over_health_consumable = 0;
-    *over_attack_consumable = 0;
-    *over_info = 0;
-    *over_small_hole = 0;
+uint64_t terrain_key(int cell, int tile) { // terrain codes (< 16) never collide with the glyphs of the layers
+    return tile == TILE_EMPTY ? 0 : state_key(cell, tile);
+}
+
+static uint64_t state_mix(uint64_t hash, int64_t value) { // order matters, unlike the xor of the arena keys
+    return mix64((hash ^ (uint64_t)value) + 0x9E3779B97F4A7C15ULL);
+}
+
+uint64_t state_hash(Arena *arena, int player_x, int player_y) {
+    uint64_t hash = 0;
+    hash = state_mix(hash, player_x);
+    hash = state_mix(hash, player_y);
+    hash = state_mix(hash, player_h);
+    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) hash = state_mix(hash, items[i]);
+    hash = state_mix(hash, weapon_flag | death_flag << 1 | arena->spikes_raised << 2);
+    hash = state_mix(hash, score);
+    hash = state_mix(hash, coins);
+    for (int i = 0; i < TIMER_KIND_COUNT; i++) hash = state_mix(hash, timer_remaining(&arena->timers, arena->timer_of[i]));
+    for (int i = 0; i < arena->boss_count; i++) {
+        const Boss *boss = &arena->bosses[i];
+        hash = state_mix(hash, (int64_t)boss->row << 32 | (uint32_t)boss->col);
+        hash = state_mix(hash, boss->frame << 8 | boss->health);
+    }
+    return hash;
+}
+
+int trace_open(const char *path) {
+    trace_close();
+    trace.fp = fopen(path, "wb");
+    if (!trace.fp) return 0;
+    setvbuf(trace.fp, trace.buffer, _IOFBF, sizeof(trace.buffer));
+    fwrite(TRACE_MAGIC, 1, 8, trace.fp);
+    trace.ticks = 0;
+    return 1;
+}
+
+void trace_tick(Arena *arena, int player_x, int player_y) {
+    TraceRecord record = { arena->hash, state_hash(arena, player_x, player_y) };
+    fwrite(&record, sizeof(record), 1, trace.fp);
+    trace.ticks++;
+}
+
+void trace_close() {
+    if (!trace.fp) return;
+    fclose(trace.fp);
+    trace.fp = NULL;
+}
+
+void trace_init() {
+    const char *path = getenv("TA_TRACE");
+    if (!path || !*path) return;
+    if (!trace_open(path)) {
+        perror(path); // the game runs untraced
+        return;
+    }
+    atexit(trace_close);
+}
+
+static FILE *trace_read_open(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    char magic[8];
+    if (!fp) perror(path);
+    else if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, TRACE_MAGIC, 8)) {
+        fprintf(stderr, "%s: not a state trace\n", path);
+        fclose(fp);
+        fp = NULL;
+    }
+    return fp;
+}
+
+int run_trace_diff(int count, char *args[]) {
+    if (count != 2) {
+        fprintf(stderr, "usage: --trace-diff <trace a> <trace b>\n");
+        return EXIT_FAILURE;
+    }
+    FILE *a = trace_read_open(args[0]);
+    FILE *b = trace_read_open(args[1]);
+    if (!a || !b) {
+        if (a) fclose(a);
+        if (b) fclose(b);
+        return EXIT_FAILURE;
+    }
+
+    TraceRecord records[2][256];
+    uint64_t tick = 0;
+    int diverged = 0;
+    while (!diverged) {
+        size_t read_a = fread(records[0], sizeof(TraceRecord), 256, a);
+        size_t read_b = fread(records[1], sizeof(TraceRecord), 256, b);
+        size_t both = read_a < read_b ? read_a : read_b;
+        for (size_t i = 0; i < both && !diverged; i++, tick++) {
+            int world = records[0][i].world != records[1][i].world, player = records[0][i].player != records[1][i].player;
+            if (!world && !player) continue;
+            printf("diverged at tick %llu: %s differ%s\n", (unsigned long long)tick, world && player ? "arena and player state" : world ? "arena state (terrain, items or warriors)" : "player state",
+                world && player ? "" : "s");
+            diverged = 1;
+        }
+        if (diverged) break;
+        if (read_a != read_b) {
+            printf("identical for %llu ticks, then %s ends\n", (unsigned long long)tick, read_a < read_b ? args[0] : args[1]);
+            diverged = 1;
+        }
+        else if (read_a < 256) {
+            printf("identical, %llu ticks\n", (unsigned long long)tick);
+            break;
+        }
+    }
+
+    fclose(a);
+    fclose(b);
+    return diverged ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /*
-    PATH FINDING
+    BENCHMARKS (./version1 --bench [max side] ~ JSON on stdout)
 */
-Queue* create_queue() {
-    Queue *queue = (Queue*)malloc(sizeof(Queue));
-    queue->front = queue->rear = NULL;
-    return queue;
-}
-
-void enqueue(Queue *queue, Point point) {
-    Node *new_node = (Node*)malloc(sizeof(Node));
-    new_node->point = point;
-    new_node->next = NULL;
-    if (queue->rear == NULL) {
-        queue->front = queue->rear = new_node;
-        return;
+typedef struct {
+    int rows, cols;
+    double walls;       // chance of a wall inside the border
+    double warriors;    // chance of a warrior on a free tile
+    char *text;         // the arena as it would be in a file
+    char *path;         // ... and that file
+    char *rle_path;     // ... and compressed
+    Arena *arena;
+    char *snapshot;     // the arena before any benchmark touched it
+    int player_x, player_y;
+    FILE *sink;         // print_arena output, counted and dropped
+    const TileKernels *kernels; // used by the tile kernel benchmarks
+    long result;        // kernel results land here so the calls are not optimized away
+    int first;          // no result printed yet
+} Bench;
+
+typedef struct {
+    const char *name;
+    void (*run)(Bench *bench);
+    void (*reset)(Bench *bench); // untimed, before every run
+} BenchOp;
+
+static ssize_t null_write(void *cookie, const char *buf, size_t size) {
+    PROFILE_COUNT(COUNTER_BYTES_WRITTEN, size);
+    return size;
+}
+
+static void bench_generate(Bench *bench, uint64_t seed) { // border walls, random walls & warriors, one key, one exit door
+    int rows = bench->rows, cols = bench->cols;
+    bench->text = (char *)game_malloc((size_t)rows * (cols + 1) + 1);
+    if (bench->text == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    char *tile = bench->text;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++, tile++) {
+            double roll = (splitmix64(&seed) >> 11) * (1.0 / 9007199254740992.0);
+            if (i == 0 || i == rows - 1) *tile = '=';
+            else if (j == 0 || j == cols - 1) *tile = '|';
+            else if (roll < bench->walls) *tile = '=';
+            else if (roll < bench->walls + bench->warriors) *tile = 'w';
+            else *tile = ' ';
+        }
+        *tile++ = '\n';
     }
-    queue->rear->next = new_node;
-    queue->rear = new_node;
+    *tile = '\0';
+
+    bench->player_x = rows / 2;
+    bench->player_y = cols / 2;
+    bench->text[(size_t)bench->player_x * (cols + 1) + bench->player_y] = 'p';
+    bench->text[(size_t)1 * (cols + 1) + 1] = 'K';
+    bench->text[(size_t)(rows - 2) * (cols + 1) + cols - 2] = 'D';
 }
 
-Point dequeue(Queue *queue) {
-    if (queue->front == NULL) {
+static void bench_setup(Bench *bench) {
+    char path[] = "/tmp/version1_benchXXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        perror("mkstemp");
         exit(EXIT_FAILURE);
     }
-    Node *temp = queue->front;
-    Point point = temp->point;
-    queue->front = queue->front->next;
-    if (queue->front == NULL) {
-        queue->rear = NULL;
+    size_t length = strlen(bench->text), done = 0;
+    while (done < length) {
+        ssize_t written = write(fd, bench->text + done, length - done);
+        if (written <= 0) {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        done += written;
+    }
+    close(fd);
+    bench->path = strdup(path);
+    bench->rle_path = (char *)game_malloc(strlen(path) + 5);
+    sprintf(bench->rle_path, "%s.rle", path);
+    if (arena_compress(bench->path, bench->rle_path) < 0) exit(EXIT_FAILURE);
+
+    bench->arena = create_arena(bench->rows, bench->cols);
+    initialize_arena(bench->arena, bench->rows, bench->cols, bench->path);
+    bench->snapshot = (char *)game_malloc(arena_snapshot_size(bench->arena));
+    if (bench->snapshot == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
     }
-    free(temp);
-    return point;
+    save_arena_snapshot(bench->arena, bench->snapshot);
 }
 
-int is_empty(Queue *queue) {
-    return queue->front == NULL;
+static void bench_teardown(Bench *bench) {
+    unlink(bench->path);
+    unlink(bench->rle_path);
+    free(bench->path);
+    game_free(bench->rle_path);
+    game_free(bench->text);
+    game_free(bench->snapshot);
+    free_arena(bench->arena);
 }
 
-void fighters_bfs(char **arena, int rows, int cols, int player_x, int player_y, int dist[rows][cols]) {
-    int visited[rows][cols];
+static void bench_restore(Bench *bench) { // warriors back where they started
+    load_arena_snapshot(bench->arena, bench->snapshot);
+    death_flag = 0;
+}
 
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            visited[i][j] = 0;
-            dist[i][j] = -1;  
+static void bench_reset_exit(Bench *bench) { // the key is never picked up, so the door stays closed
+    exit_arena = 0;
+}
+
+static void bench_fighters_bfs(Bench *bench) {
+    fighters_bfs(bench->arena, bench->rows, bench->cols, bench->player_x, bench->player_y, NULL, 0); // the whole arena
+}
+
+static void bench_move_fighters(Bench *bench) {
+    move_fighters(bench->arena, bench->rows, bench->cols, bench->player_x, bench->player_y);
+}
+
+static void bench_arena_exit(Bench *bench) {
+    handle_arena_exit(bench->arena);
+}
+
+static void bench_move_fighters_generic(Bench *bench) { // the same arena without its fixed-size variant
+    int small = bench->arena->small;
+    bench->arena->small = 0;
+    bench_move_fighters(bench);
+    bench->arena->small = small;
+}
+
+static void bench_arena_exit_generic(Bench *bench) {
+    int small = bench->arena->small;
+    bench->arena->small = 0;
+    bench_arena_exit(bench);
+    bench->arena->small = small;
+}
+
+static void bench_loader(Bench *bench) {
+    int rows, cols;
+    get_arena_dimensions(bench->path, &rows, &cols);
+    Arena *arena = create_arena(rows, cols);
+    initialize_arena(arena, rows, cols, bench->path);
+    free_arena(arena);
+}
+
+static void bench_loader_rle(Bench *bench) {
+    int rows, cols;
+    get_arena_dimensions(bench->rle_path, &rows, &cols);
+    Arena *arena = create_arena(rows, cols);
+    initialize_arena(arena, rows, cols, bench->rle_path);
+    free_arena(arena);
+}
+
+static void bench_print_arena(Bench *bench) {
+    FILE *terminal = stdout;
+    stdout = bench->sink;
+    camera = (Camera){0, 0, bench->rows, bench->cols}; // the whole arena, as if the terminal was big enough
+    print_arena(bench->arena, bench->rows, bench->cols, bench->player_x, bench->player_y);
+    fflush(stdout);
+    stdout = terminal;
+}
+
+static void bench_count_tiles(Bench *bench) {
+    bench->result = bench->kernels->count(bench->arena->terrain, (size_t)bench->rows * bench->arena->stride, TILE_WALL);
+}
+
+static void bench_find_tile(Bench *bench) { // the exit door is the last tile of the arena ~ a full scan
+    bench->result = bench->kernels->find(bench->arena->terrain, (size_t)bench->rows * bench->arena->stride, 0, TILE_EXIT_DOOR);
+}
+
+static void bench_replace_tiles(Bench *bench) {
+    bench->kernels->replace(bench->arena->terrain, (size_t)bench->rows * bench->arena->stride, TILE_WALL, TILE_SPIKE);
+}
+
+static void bench_reset_tiles(Bench *bench) { // the generated arenas have no spikes
+    replace_tiles_scalar(bench->arena->terrain, (size_t)bench->rows * bench->arena->stride, TILE_SPIKE, TILE_WALL);
+    vision_reset(bench->arena); // the kernels write the terrain behind set_terrain's back
+    passability_rebuild(bench->arena);
+}
+
+static void bench_run(Bench *bench, const BenchOp *op) {
+    uint64_t timed = 0, iterations = 0;
+    uint64_t counters[COUNTER_COUNT] = {0};
+    uint64_t began = monotonic_ns();
+
+    while (!iterations || (timed < BENCH_TARGET_NS && iterations < BENCH_MAX_ITERATIONS && 
+        monotonic_ns() - began < 5 * BENCH_TARGET_NS)) { // resets are not timed but still take a while
+        if (op->reset) op->reset(bench);
+        for (int i = 0; i < COUNTER_COUNT; i++) profiler.frame[i] = 0;
+
+        uint64_t start = monotonic_ns();
+        op->run(bench);
+        timed += monotonic_ns() - start;
+
+        for (int i = 0; i < COUNTER_COUNT; i++) counters[i] += profiler.frame[i];
+        iterations++;
+    }
+
+    printf("%s    {\"name\": \"%s\", \"kernels\": \"%s\", \"rows\": %d, \"cols\": %d, \"walls\": %.2f, \"warriors\": %.3f, \"iterations\": %llu, "
+        "\"ns_per_op\": %.1f, \"allocs_per_op\": %.1f, \"alloc_bytes_per_op\": %.1f, \"bytes_written_per_op\": %.1f, \"bfs_nodes_per_op\": %.1f, "
+        "\"vision_casts_per_op\": %.1f}",
+        bench->first ? "" : ",\n", op->name, bench->kernels->name, bench->rows, bench->cols, bench->walls, bench->warriors, (unsigned long long)iterations,
+        (double)timed / iterations, (double)counters[COUNTER_ALLOCS] / iterations, (double)counters[COUNTER_ALLOC_BYTES] / iterations,
+        (double)counters[COUNTER_BYTES_WRITTEN] / iterations, (double)counters[COUNTER_BFS_NODES] / iterations,
+        (double)counters[COUNTER_VISION_CASTS] / iterations);
+    fflush(stdout);
+    bench->first = 0;
+}
+
+int run_benchmarks(int count, char *args[]) {
+    int max_side = count ? atoi(args[0]) : 4096;
+    if (max_side < 10) {
+        fprintf(stderr, "usage: --bench [max side, at least 10]\n");
+        return EXIT_FAILURE;
+    }
+
+    const int sides[] = {10, 16, 32, 64, 256, 1024, 4096};
+    const double densities[][2] = {{0.10, 0.002}, {0.30, 0.02}}; // walls, warriors
+    const BenchOp ops[] = {
+        {"fighters_bfs", bench_fighters_bfs, NULL},
+        {"move_fighters", bench_move_fighters, bench_restore},
+        {"handle_arena_exit", bench_arena_exit, bench_reset_exit},
+        {"loader", bench_loader, NULL},
+        {"loader_rle", bench_loader_rle, NULL},
+        {"print_arena", bench_print_arena, NULL},
+    };
+    const BenchOp kernel_ops[] = { // once per supported kernel set
+        {"count_tiles", bench_count_tiles, NULL},
+        {"find_tile", bench_find_tile, NULL},
+        {"replace_tiles", bench_replace_tiles, bench_reset_tiles},
+    };
+    const BenchOp small_ops[] = { // arenas with a fixed-size variant, for comparison
+        {"move_fighters_generic", bench_move_fighters_generic, bench_restore},
+        {"handle_arena_exit_generic", bench_arena_exit_generic, bench_reset_exit},
+    };
+
+    Bench bench = {0};
+    bench.first = 1;
+    bench.sink = write_stream(null_write);
+    if (bench.sink == NULL) bench.sink = fopen("/dev/null", "w"); // no cookie streams ~ print_arena's bytes are not counted
+    if (bench.sink == NULL) {
+        perror("fopen");
+        exit(EXIT_FAILURE);
+    }
+    profiler.enabled = 1; // counters only, nothing is reported on exit
+
+    printf("{\n  \"benchmarks\": [\n");
+    for (int s = 0; s < (int)(sizeof(sides) / sizeof(sides[0])) && sides[s] <= max_side; s++) {
+        for (int d = 0; d < (int)(sizeof(densities) / sizeof(densities[0])); d++) {
+            bench.rows = bench.cols = sides[s];
+            bench.walls = densities[d][0];
+            bench.warriors = densities[d][1];
+            bench_generate(&bench, 0x5eed + s * 16 + d);
+            bench_setup(&bench);
+            bench.kernels = &tile_kernels;
+            for (int o = 0; o < (int)(sizeof(ops) / sizeof(ops[0])); o++) bench_run(&bench, &ops[o]);
+            for (int o = 0; bench.arena->small && o < (int)(sizeof(small_ops) / sizeof(small_ops[0])); o++) bench_run(&bench, &small_ops[o]);
+            for (int k = 0; k < TILE_KERNEL_COUNT; k++) {
+                if (!tile_kernels_supported(&TILE_KERNELS[k])) continue;
+                bench.kernels = &TILE_KERNELS[k];
+                for (int o = 0; o < (int)(sizeof(kernel_ops) / sizeof(kernel_ops[0])); o++) bench_run(&bench, &kernel_ops[o]);
+            }
+            bench_teardown(&bench);
         }
     }
+    printf("\n  ]\n}\n");
 
-    Queue *queue = create_queue();
-    enqueue(queue, (Point){player_x, player_y});
-    visited[player_x][player_y] = 1;
-    dist[player_x][player_y] = 0;
+    profiler.enabled = 0;
+    fclose(bench.sink);
+    return 0;
+}
 
-    while (!is_empty(queue)) { // bfs
-        Point current = dequeue(queue);
+/*
+    SELF TEST (./version1 --selftest [test] ~ deterministic checks of the solver, file formats & kernels, exit status = pass / fail)
+*/
+typedef struct {
+    const char *dir;    // scratch directory, removed afterwards
+    int checks;
+    int failures;
+} SelfTest;
 
-        for (int i = 0; i < 4; i++) {  // explore the 4 directions 
-            int new_row = current.row + row_dir[i];
-            int new_col = current.col + col_dir[i];
+typedef struct {
+    const char *name;
+    void (*run)(SelfTest *test);
+} SelfTestCase;
+
+#define SELFTEST_CHECK(test, condition, ...) do { \
+    (test)->checks++; \
+    if (!(condition)) { \
+        (test)->failures++; \
+        fprintf(stderr, "  failed: " __VA_ARGS__); \
+        fputc('\n', stderr); \
+    } \
+} while (0)
+
+static void selftest_path(SelfTest *test, const char *name, char *path) {
+    snprintf(path, MAX_PATH_LENGTH, "%s/%s", test->dir, name);
+}
 
-            // check if new position is within bounds, walkable, and not visited
-            if (new_row >= 0 && new_row < rows && new_col >= 0 && new_col < cols &&
-                arena[new_row][new_col] != '|' && arena[new_row][new_col] != '=' && arena[new_row][new_col] != 'x' 
-                && arena[new_row][new_col] != 'O' && arena[new_row][new_col] != 'D' && arena[new_row][new_col] != 'd' &&
-                arena[new_row][new_col] != '#' && !visited[new_row][new_col]) {
+static int selftest_redirect(FILE *stream, const char *path, int saved) { // -1 = stream goes to path & the old one is returned, else restore it
+    int fd = fileno(stream);
+    fflush(stream);
+    if (saved != -1) {
+        dup2(saved, fd);
+        close(saved);
+        return -1;
+    }
+    saved = dup(fd);
+    int file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file != -1) {
+        dup2(file, fd);
+        close(file);
+    }
+    return saved;
+}
+
+static int selftest_mute(int saved) { // -1 = silence stderr & return the old one, else restore it (expected errors stay off the report)
+    return selftest_redirect(stderr, "/dev/null", saved);
+}
+
+static void selftest_solver(SelfTest *test) { // the shortest solution of arena0 replays to its exit, an arena without one is reported
+    char report[MAX_LINE_LENGTH * 4];
+    solve_arena("arena0.txt", report, sizeof(report));
+    report[strcspn(report, "\n")] = '\0';
+    const char *moves = strstr(report, "): ");
+    SELFTEST_CHECK(test, moves && strstr(report, "solved in 34 moves"), "solver: %s", report);
+
+    int rows, cols;
+    get_arena_dimensions("arena0.txt", &rows, &cols);
+    Arena *arena = create_arena(rows, cols);
+    initialize_arena(arena, rows, cols, "arena0.txt");
+    int x = arena->start_row, y = arena->start_col, played = 0;
+    player_h = 100; weapon_flag = 0; death_flag = 0; coins = 0;
+    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
+    TickResult result = TICK_CONTINUE;
+    for (moves = moves ? moves + 3 : ""; *moves && result != TICK_ARENA_EXIT; moves++, played++) result = simulate_tick(arena, rows, cols, &x, &y, *moves);
+    SELFTEST_CHECK(test, result == TICK_ARENA_EXIT && played == 34, "solver: the solution of arena0.txt ends with %d after %d moves", result, played);
+    free_arena(arena);
 
-                enqueue(queue, (Point){new_row, new_col});
-                visited[new_row][new_col] = 1;
-                dist[new_row][new_col] = dist[current.row][current.col] + 1;  // increment dist
+    solve_arena("test.txt", report, sizeof(report));
+    SELFTEST_CHECK(test, strstr(report, "unsolvable, the arena has no exit") != NULL, "solver: %s", report);
+}
+
+static void selftest_kernels(SelfTest *test) { // every supported kernel set against the scalar one, all lengths & alignments up to a few vectors
+    unsigned char buffer[200 + 32], expected[200 + 32], actual[200 + 32];
+    uint64_t seed = 0x51;
+    for (int k = 1; k < TILE_KERNEL_COUNT; k++) {
+        const TileKernels *kernels = &TILE_KERNELS[k];
+        if (!tile_kernels_supported(kernels)) continue;
+        int failures = test->failures;
+        for (size_t bytes = 0; bytes <= 200 && test->failures == failures; bytes++) {
+            size_t offset = bytes % 32; // unaligned starts
+            for (size_t i = 0; i < sizeof(buffer); i++) buffer[i] = splitmix64(&seed) % 3 ? 0x00 : (unsigned char)splitmix64(&seed); // mostly empty tiles, like a real arena
+            unsigned char *tiles = buffer + offset;
+            for (int tile = 0; tile < 16; tile++) {
+                SELFTEST_CHECK(test, kernels->count(tiles, bytes, tile) == TILE_KERNELS[0].count(tiles, bytes, tile), "kernels: %s count of %d in %zu bytes", kernels->name, tile, bytes);
+                for (size_t from = 0; from <= 2 * bytes; from += 1 + from / 8) {
+                    SELFTEST_CHECK(test, kernels->find(tiles, bytes, from, tile) == TILE_KERNELS[0].find(tiles, bytes, from, tile),
+                        "kernels: %s find of %d from %zu in %zu bytes", kernels->name, tile, from, bytes);
+                }
+                int to = splitmix64(&seed) % 16;
+                memcpy(expected, buffer, sizeof(buffer));
+                memcpy(actual, buffer, sizeof(buffer));
+                TILE_KERNELS[0].replace(expected + offset, bytes, tile, to);
+                kernels->replace(actual + offset, bytes, tile, to);
+                SELFTEST_CHECK(test, !memcmp(expected, actual, sizeof(buffer)), "kernels: %s replace of %d by %d in %zu bytes", kernels->name, tile, to, bytes);
             }
         }
     }
+}
 
-    free(queue);  
+static void selftest_world_tick(World *world, uint64_t *seed) { // the same plantings, harvests & ore for every world given the same seed
+    for (int k = 0; k < 4; k++) {
+        long row = splitmix64(seed) % world->rows, col = splitmix64(seed) % world->cols;
+        uint64_t roll = splitmix64(seed) % 8;
+        if (roll < 3 && world_get(world, row, col) == ' ') world_set(world, row, col, roll ? WORLD_SEED : WORLD_SAPLING);
+        else if (roll == 3) world_schedule(world, 1 + splitmix64(seed) % 200, row, col, WORLD_ORE);
+        else world_gather(world, row, col);
+    }
+    world_advance(world);
 }
 
-void move_fighters(char **arena, int rows, int cols, int player_x, int player_y) {
-    int dist[rows][cols];
+static void selftest_world_lazy(SelfTest *test) { // chunks that catch up when they are read match chunks kept up to date every tick
+    char lazy_path[MAX_PATH_LENGTH], eager_path[MAX_PATH_LENGTH];
+    selftest_path(test, "lazy.world", lazy_path);
+    selftest_path(test, "eager.world", eager_path);
+    World *lazy = world_create(lazy_path, 200, 230), *eager = world_create(eager_path, 200, 230);
+    SELFTEST_CHECK(test, lazy && eager, "world_lazy: create");
+    if (!lazy || !eager) return;
+    world_close(lazy);
+    lazy = world_open(lazy_path, 0); // WORLD_MIN_CHUNKS slots of 56 chunks ~ most of them are evicted & caught up later
+    uint64_t lazy_seed = 0x1a2, eager_seed = 0x1a2;
+    for (int t = 0; t < 1000; t++) { // more than a dozen growth stages
+        selftest_world_tick(lazy, &lazy_seed);
+        selftest_world_tick(eager, &eager_seed);
+        world_focus(eager, 0, 0, eager->chunk_rows + eager->chunk_cols); // every chunk, every tick
+    }
 
-    fighters_bfs(arena, rows, cols, player_x, player_y, dist); // calculate distances from the player for each warrior
+    for (int reopen = 0; reopen < 2; reopen++) { // and again from the file, the chunk ticks were saved
+        long differ = 0, first = -1;
+        for (long i = 0; i < lazy->rows; i++) {
+            for (long j = 0; j < lazy->cols; j++) {
+                if (world_get(lazy, i, j) == world_get(eager, i, j)) continue;
+                if (first == -1) first = i * lazy->cols + j;
+                differ++;
+            }
+        }
+        SELFTEST_CHECK(test, !differ && lazy->tick == eager->tick && (reopen || lazy->fired == eager->fired), "world_lazy: %ld tiles differ after %ld ticks (first %ld)%s",
+            differ, (long)lazy->tick, first, reopen ? " and a reopen" : "");
+        world_close(lazy);
+        lazy = world_open(lazy_path, 0);
+        if (lazy == NULL) return;
+    }
+    world_close(lazy);
+    world_close(eager);
+    unlink(lazy_path);
+    unlink(eager_path);
+}
 
-    char new_arena[rows][cols];
+static int compare_scores(const void *a, const void *b) { // best first
+    return *(const int *)b - *(const int *)a;
+}
 
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) new_arena[i][j] = arena[i][j];
+static void selftest_leaderboard(SelfTest *test) { // compactions keep every run in order, damaged log entries are skipped
+    enum { RUNS = 2 * LEADERBOARD_LOG_LIMIT + 100 };
+    char base[MAX_PATH_LENGTH], path[MAX_PATH_LENGTH];
+    selftest_path(test, "leaderboard", base);
+    const char *previous = getenv("TA_LEADERBOARD");
+    char *restore = previous ? strdup(previous) : NULL;
+    setenv("TA_LEADERBOARD", base, 1);
+
+    int *scores = (int *)game_malloc(RUNS * sizeof(int));
+    LeaderboardEntry *top = (LeaderboardEntry *)game_malloc(RUNS * sizeof(LeaderboardEntry));
+    if (scores == NULL || top == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t seed = 0x1eade;
+    int recorded = 0;
+    for (int i = 0; i < RUNS; i++) {
+        scores[i] = splitmix64(&seed) % 100000;
+        recorded += leaderboard_record(scores[i], i % 7, i % 4) == 0;
+    }
+    SELFTEST_CHECK(test, recorded == RUNS, "leaderboard: %d of %d runs recorded", recorded, RUNS);
+    qsort(scores, RUNS, sizeof(int), compare_scores);
+
+    Leaderboard board;
+    if (leaderboard_open(&board, LOCK_SH) == 0) {
+        SELFTEST_CHECK(test, board.generation == 2 && board.table_count + board.log_count == RUNS, "leaderboard: generation %ld, %ld + %ld runs after %d",
+            (long)board.generation, (long)board.table_count, (long)board.log_count, RUNS);
+        int sorted = 1;
+        for (long i = 1; i < board.table_count; i++) sorted &= compare_entries(&board.table[i - 1], &board.table[i]) <= 0;
+        SELFTEST_CHECK(test, sorted, "leaderboard: compacted table out of order");
+        int count = leaderboard_top(&board, RUNS, top), same = count == RUNS;
+        for (int i = 0; same && i < count; i++) same = top[i].score == scores[i];
+        SELFTEST_CHECK(test, same, "leaderboard: top %d differs from every recorded score", count);
+        SELFTEST_CHECK(test, leaderboard_rank(&board, scores[0] + 1) == 1 && leaderboard_rank(&board, -1) == RUNS + 1, "leaderboard: ranks");
+        leaderboard_close(&board);
+    }
+    else SELFTEST_CHECK(test, 0, "leaderboard: open");
+
+    LeaderboardEntry damaged = { 0, 999999, 0, 0, 0 }; // bad crc, then half an entry
+    leaderboard_path(path, ".log");
+    int fd = open(path, O_WRONLY | O_APPEND);
+    int appended = fd != -1 && write(fd, &damaged, sizeof(damaged)) == sizeof(damaged) && write(fd, &damaged, sizeof(damaged) / 2) == sizeof(damaged) / 2;
+    if (fd != -1) close(fd);
+    if (appended && leaderboard_open(&board, LOCK_SH) == 0) {
+        SELFTEST_CHECK(test, board.table_count + board.log_count == RUNS && leaderboard_rank(&board, scores[0] + 1) == 1, "leaderboard: a damaged log entry was read");
+        leaderboard_close(&board);
     }
 
-    int moved = 0;
+    game_free(scores);
+    game_free(top);
+    unlink(path);
+    leaderboard_path(path, ".tbl");
+    unlink(path);
+    if (restore) setenv("TA_LEADERBOARD", restore, 1);
+    else unsetenv("TA_LEADERBOARD");
+    free(restore);
+}
 
-    for (int i = 0; i < rows; i++) { // calculate where 'w' go
-        for (int j = 0; j < cols; j++) {
-            if (arena[i][j] == 'w') {
-                int min_dist = dist[i][j];
-                int next_row = i, next_col = j;
-                int found_better_move = 0;
+static void selftest_rle(SelfTest *test) { // text and .rle loads of the same arena give the same layers
+    static const char glyphs[] = "  ===||xo**+^)ckKdDO#w!<>~$TUVW19";
+    for (int round = 0; round < 8; round++) {
+        uint64_t seed = 0x41e + round;
+        Bench bench = {0};
+        bench.rows = 3 + splitmix64(&seed) % 40;
+        bench.cols = 3 + splitmix64(&seed) % 400; // runs past 127 take more than one count byte
+        bench.text = (char *)game_malloc((size_t)bench.rows * (bench.cols + 1) + 1);
+        if (bench.text == NULL) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        char *tile = bench.text;
+        for (int i = 0; i < bench.rows; i++) {
+            int length = i == 0 ? bench.cols : 1 + (int)(splitmix64(&seed) % bench.cols); // short lines, the rest is empty
+            for (int j = 0; j < length; ) {
+                char glyph = glyphs[splitmix64(&seed) % (sizeof(glyphs) - 1)];
+                int run = splitmix64(&seed) % 4 ? 1 : 1 + splitmix64(&seed) % 300;
+                for (int end = j + run; j < end && j < length; j++) *tile++ = glyph;
+            }
+            *tile++ = '\n';
+        }
+        *tile = '\0';
+        bench.text[bench.cols + 1 + 1] = 'p'; // row 1 always reaches column 1
+        bench_setup(&bench);
+
+        Arena *rle = create_arena(bench.rows, bench.cols);
+        int rows, cols;
+        get_arena_dimensions(bench.rle_path, &rows, &cols);
+        initialize_arena(rle, bench.rows, bench.cols, bench.rle_path);
+        int same = rows == bench.rows && cols == bench.cols && rle->hash == bench.arena->hash &&
+            rle->start_row == bench.arena->start_row && rle->start_col == bench.arena->start_col;
+        for (int i = 0; same && i < bench.rows; i++) {
+            for (int j = 0; same && j < bench.cols; j++) same = arena_tile(rle, i, j) == arena_tile(bench.arena, i, j);
+        }
+        SELFTEST_CHECK(test, same, "rle: %dx%d arena %d differs from its text", bench.rows, bench.cols, round);
+        free_arena(rle);
+
+        struct stat info; // a cut file keeps its size, the missing rows stay empty
+        if (stat(bench.rle_path, &info) == 0 && truncate(bench.rle_path, sizeof(RleHeader) + (info.st_size - sizeof(RleHeader)) / 2) == 0) {
+            get_arena_dimensions(bench.rle_path, &rows, &cols);
+            rle = create_arena(rows, cols);
+            initialize_arena(rle, rows, cols, bench.rle_path);
+            SELFTEST_CHECK(test, rows == bench.rows && cols == bench.cols && arena_tile(rle, bench.rows - 1, bench.cols - 1) == ' ', "rle: truncated arena %d", round);
+            free_arena(rle);
+        }
+        bench_teardown(&bench);
+    }
 
-                for (int d = 0; d < 4; d++) { // check all 4 possible directions
-                    int new_row = i + row_dir[d];
-                    int new_col = j + col_dir[d];
+    static const int32_t damages[][2] = { {-1, 10}, {10, -1}, {ARENA_MAX_SIDE + 1, 10}, {10, INT32_MAX} }; // the load ends before any arena is sized
+    char path[MAX_PATH_LENGTH];
+    selftest_path(test, "damaged.rle", path);
+    for (int d = 0; d < (int)(sizeof(damages) / sizeof(damages[0])); d++) {
+        RleHeader header = { .rows = damages[d][0], .cols = damages[d][1] };
+        memcpy(header.magic, RLE_MAGIC, 8);
+        FILE *fp = fopen(path, "wb");
+        int written = fp && fwrite(&header, sizeof(header), 1, fp) == 1;
+        if (fp) fclose(fp);
+        fflush(stdout); // the child exits through stdio
+        pid_t pid = written ? fork() : -1;
+        if (!pid) {
+            selftest_mute(-1);
+            int rows, cols;
+            get_arena_dimensions(path, &rows, &cols);
+            Arena *arena = create_arena(rows, cols);
+            initialize_arena(arena, rows, cols, path);
+            _exit(EXIT_SUCCESS);
+        }
+        int status = 0;
+        if (pid > 0) waitpid(pid, &status, 0);
+        SELFTEST_CHECK(test, pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE, "rle: a %dx%d header was loaded", damages[d][0], damages[d][1]);
+    }
+    unlink(path);
+}
 
-                    if (new_row >= 0 && new_row < rows && new_col >= 0 && new_col < cols &&
-                        dist[new_row][new_col] != -1 && dist[new_row][new_col] < min_dist &&
-                        (arena[new_row][new_col] == ' ' || arena[new_row][new_col] == 'o' || arena[new_row][new_col] == '+' || 
-                        arena[new_row][new_col] == '^' || arena[new_row][new_col] == 'p')) {
+static long selftest_terrain_changes(Arena *a, Arena *b) {
+    long changes = 0;
+    for (int i = 0; i < a->rows; i++) {
+        for (int j = 0; j < a->cols; j++) changes += terrain_at(a, i, j) != terrain_at(b, i, j);
+    }
+    return changes;
+}
 
-                        min_dist = dist[new_row][new_col];
-                        next_row = new_row;
-                        next_col = new_col;
-                        found_better_move = 1;
-                    }
-                }
+static void selftest_journal(SelfTest *test) { // undo / redo round trips, the delta file & its checks, no allocation inside a tick
+    static const int tiles[] = { TILE_EMPTY, TILE_WALL, TILE_SPIKE, TILE_SMALL_HOLE };
+    Bench bench = {0};
+    bench.rows = 41;
+    bench.cols = 67;
+    bench.walls = 0.2;
+    bench_generate(&bench, 0x10a2);
+    bench_setup(&bench);
+    Arena *arena = bench.arena;
+    uint64_t seed = 46, start = arena->hash;
+
+    int steps = 0;
+    for (int t = 0; t < 600; t++) { // more steps than JOURNAL_FIRST_ENTRIES, so the journal grows
+        int row = 1 + splitmix64(&seed) % (bench.rows - 2), col = 1 + splitmix64(&seed) % (bench.cols - 2);
+        uint64_t roll = splitmix64(&seed) % 10;
+        journal_reserve(arena);
+        uint64_t allocs = alloc_stats.allocs;
+        if (roll == 0) journal_undo(arena);
+        else if (roll == 1) journal_redo(arena);
+        else {
+            journal_set(arena, row, col, tiles[splitmix64(&seed) % 4]);
+            if (roll & 1) journal_checkpoint(arena); // some steps span several writes
+        }
+        SELFTEST_CHECK(test, alloc_stats.allocs == allocs, "journal: tick %d allocated after journal_reserve", t);
+        steps++;
+    }
+    journal_checkpoint(arena);
+    uint64_t end = arena->hash;
+    int undone = 0;
+    while (journal_undo(arena)) undone++;
+    SELFTEST_CHECK(test, arena->hash == start, "journal: undoing %d steps does not restore the arena", undone);
+    while (journal_redo(arena)) undone--;
+    SELFTEST_CHECK(test, !undone && arena->hash == end, "journal: redo does not replay every undone step");
 
-                if (found_better_move) {
+    char path[MAX_PATH_LENGTH];
+    selftest_path(test, "building.delta", path);
+    Arena *fresh = create_arena(bench.rows, bench.cols);
+    initialize_arena(fresh, bench.rows, bench.cols, bench.path);
+    long size = journal_save(arena, path);
+    JournalHeader header = {0};
+    FILE *fp = fopen(path, "rb");
+    int read = fp && fread(&header, sizeof(header), 1, fp) == 1;
+    if (fp) fclose(fp);
+    SELFTEST_CHECK(test, size > 0 && read && !memcmp(header.magic, JOURNAL_MAGIC, 8) && header.rows == bench.rows && header.cols == bench.cols,
+        "journal: delta header");
+    SELFTEST_CHECK(test, header.count == selftest_terrain_changes(arena, fresh), "journal: delta holds %d cells, %ld changed", header.count, selftest_terrain_changes(arena, fresh));
+    SELFTEST_CHECK(test, journal_load(fresh, path) && fresh->hash == arena->hash, "journal: delta does not rebuild the arena");
+    uint64_t before = fresh->hash; // the delta is applied already ~ its old tiles no longer match
+    SELFTEST_CHECK(test, !journal_load(fresh, path) && fresh->hash == before, "journal: a delta for other tiles was applied");
+    SELFTEST_CHECK(test, journal_undo(fresh) && fresh->hash == start, "journal: a loaded delta is not one undo step");
+
+    if (truncate(path, size - 1) == 0) {
+        free_arena(fresh);
+        fresh = create_arena(bench.rows, bench.cols);
+        initialize_arena(fresh, bench.rows, bench.cols, bench.path);
+        before = fresh->hash;
+        SELFTEST_CHECK(test, !journal_load(fresh, path) && fresh->hash == before, "journal: a truncated delta was not rolled back");
+    }
+    Arena *other = create_arena(bench.rows + 1, bench.cols);
+    for (int i = 0; i < bench.rows + 1; i++) arena_put(other, i, 0, '|');
+    before = other->hash;
+    SELFTEST_CHECK(test, !journal_load(other, path) && other->hash == before, "journal: a delta for another size was applied");
+
+    free_arena(other);
+    free_arena(fresh);
+    unlink(path);
+    bench_teardown(&bench);
+}
 
-                    if (next_row == player_x && next_col == player_y && !weapon_flag) {
-                        death_flag = 1;
-                        return;  // exit when reaching the player
-                    }
+static void selftest_world(SelfTest *test) { // the trailer keeps the tick & pending events, damaged ones are refused
+    char path[MAX_PATH_LENGTH];
+    selftest_path(test, "selftest.world", path);
+    World *world = world_create(path, 100, 130);
+    SELFTEST_CHECK(test, world != NULL, "world: create");
+    if (world == NULL) return;
+    uint64_t seed = 50;
+    for (int i = 0; i < 40; i++) world_schedule(world, 1 + splitmix64(&seed) % 300, splitmix64(&seed) % 100, splitmix64(&seed) % 130, WORLD_ORE);
+    for (int t = 0; t < 120; t++) world_advance(world);
+    int64_t tick = world->tick;
+    int pending = world->event_count;
+    WorldEvent events[40];
+    memcpy(events, world->events, pending * sizeof(WorldEvent));
+    off_t trailer = world_trailer(world);
+    world_close(world);
+
+    world = world_open(path, WORLD_DEFAULT_BUDGET);
+    SELFTEST_CHECK(test, world && world->tick == tick && world->event_count == pending && !memcmp(world->events, events, pending * sizeof(WorldEvent)),
+        "world: reopened at tick %ld with %d events, closed at %ld with %d", world ? (long)world->tick : -1L, world ? world->event_count : -1, (long)tick, pending);
+    if (world) world_close(world);
+
+    const struct { const char *what; off_t at; int64_t value; } damages[] = {
+        {"a negative event count", trailer + offsetof(WorldTrailer, events), -1},
+        {"an event count past the end of the file", trailer + offsetof(WorldTrailer, events), pending + 1},
+        {"an event count of 2^40", trailer + offsetof(WorldTrailer, events), (int64_t)1 << 40},
+        {"a negative tick", trailer + offsetof(WorldTrailer, tick), -1},
+        {"an event outside the world", trailer + sizeof(WorldTrailer) + offsetof(WorldEvent, row), 100},
+        {"events out of heap order", trailer + sizeof(WorldTrailer) + offsetof(WorldEvent, tick), INT64_MAX},
+    };
+    int fd = open(path, O_RDWR);
+    for (int d = 0; fd != -1 && pending > 1 && d < (int)(sizeof(damages) / sizeof(damages[0])); d++) {
+        int64_t good;
+        if (pread(fd, &good, sizeof(good), damages[d].at) != sizeof(good) || pwrite(fd, &damages[d].value, sizeof(good), damages[d].at) != sizeof(good)) break;
+        int saved = selftest_mute(-1);
+        world = world_open(path, WORLD_DEFAULT_BUDGET);
+        selftest_mute(saved);
+        SELFTEST_CHECK(test, world == NULL, "world: a trailer with %s was opened", damages[d].what);
+        if (world) world_close(world);
+        if (pwrite(fd, &good, sizeof(good), damages[d].at) != sizeof(good)) break;
+    }
+    if (fd != -1 && ftruncate(fd, trailer) == 0) { // written before the simulation ~ tick 0, nothing pending
+        world = world_open(path, WORLD_DEFAULT_BUDGET);
+        SELFTEST_CHECK(test, world && world->tick == 0 && world->event_count == 0, "world: a file without a trailer");
+        if (world) world_close(world);
+    }
+    if (fd != -1) close(fd);
+    unlink(path);
+}
 
-                    if (new_arena[next_row][next_col] == ' ' || new_arena[next_row][next_col] == 'o' || new_arena[next_row][next_col] == '+' ||
-                     new_arena[next_row][next_col] == '^' || arena[next_row][next_col] == 'p') {
-                        new_arena[next_row][next_col] = 'w';  
-                        new_arena[i][j] = ' ';  
-                        moved = 1;
-                    }
-                }
+static int selftest_small_run(const char *path, int small, int armed, uint64_t seed, uint64_t *trace, int length) { // one random game, 0 = the arena has no fixed-size variant
+    int rows, cols;
+    get_arena_dimensions(path, &rows, &cols);
+    Arena *arena = create_arena(rows, cols);
+    initialize_arena(arena, rows, cols, path);
+    int had_small = arena->small;
+    if (!small) arena->small = 0; // the generic paths, as bench_move_fighters_generic runs them
+    int x = arena->start_row, y = arena->start_col;
+    player_h = 100; weapon_flag = armed; death_flag = 0; coins = 0; score = 0;
+    for (int i = 0; i < MAX_INVENTORY_ITEMS; i++) items[i] = '\0';
+    for (int t = 0; t < length; t++) trace[t] = 0;
+    for (int t = 0; t < length; t++) {
+        TickResult result = simulate_tick(arena, rows, cols, &x, &y, SOLVER_MOVES[splitmix64(&seed) % (sizeof(SOLVER_MOVES) - 1)]);
+        trace[t] = state_hash(arena, x, y) ^ ((uint64_t)result << 56 | (uint64_t)x << 28 | (uint64_t)y);
+        if (result != TICK_CONTINUE && result != TICK_INFO) break;
+    }
+    free_arena(arena);
+    return had_small;
+}
+
+static void selftest_small(SelfTest *test) { // the fixed-size fighter & exit paths play every tick like the generic ones
+    enum { TICKS = 400 };
+    static const char glyphs[] = "        ====wwwxKo+^Ddk";
+    uint64_t small[TICKS], generic[TICKS];
+    char path[MAX_PATH_LENGTH];
+    selftest_path(test, "small.txt", path);
+    uint64_t seed = 47;
+    for (int round = 0; round < 200; round++) {
+        int rows = 4 + splitmix64(&seed) % 29, cols = 4 + splitmix64(&seed) % 29; // both fixed sizes, 16 & 32
+        int start_row = 1 + splitmix64(&seed) % (rows - 2), start_col = 1 + splitmix64(&seed) % (cols - 2);
+        FILE *fp = fopen(path, "w");
+        if (fp == NULL) {
+            SELFTEST_CHECK(test, 0, "small: fopen %s", path);
+            return;
+        }
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                char glyph = glyphs[splitmix64(&seed) % (sizeof(glyphs) - 1)];
+                if (i == 0 || i == rows - 1) glyph = '=';
+                else if (j == 0 || j == cols - 1) glyph = '|';
+                else if (i == start_row && j == start_col) glyph = 'p';
+                fputc(glyph, fp);
             }
+            fputc('\n', fp);
         }
+        fclose(fp);
+
+        uint64_t moves = splitmix64(&seed);
+        int had_small = selftest_small_run(path, 1, round & 1, moves, small, TICKS); // armed players outlive the warriors, the games last longer
+        selftest_small_run(path, 0, round & 1, moves, generic, TICKS);
+        int tick = 0;
+        while (tick < TICKS && small[tick] == generic[tick]) tick++;
+        SELFTEST_CHECK(test, had_small && tick == TICKS, "small: %dx%d arena %d differs from the generic paths at tick %d", rows, cols, round, tick);
     }
+    unlink(path);
+}
 
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) arena[i][j] = new_arena[i][j];    
+static int selftest_trace_run(SelfTest *test, const char *script, const char *name, BatchResult *result, char *output) { // batch run traced into <dir>/<name>/, then --trace-diff against <dir>/a
+    static char *arenas[] = { "welcome.txt", "arena0.txt", "arena1.txt", "arena2.txt" };
+    char dir[MAX_PATH_LENGTH], trace[MAX_PATH_LENGTH], first[MAX_PATH_LENGTH], report[MAX_PATH_LENGTH], relative[32];
+    selftest_path(test, name, dir);
+    mkdir(dir, 0755);
+    setenv("TA_TRACE", dir, 1);
+    batch_run(script, arenas, sizeof(arenas) / sizeof(arenas[0]), result); // writes <dir>/<name>/<script>.trace
+    unsetenv("TA_TRACE");
+
+    snprintf(relative, sizeof(relative), "%s/replay.trace", name);
+    selftest_path(test, relative, trace);
+    selftest_path(test, "a/replay.trace", first);
+    selftest_path(test, "trace_diff.txt", report);
+    char *args[] = { first, trace };
+    int saved = selftest_redirect(stdout, report, -1);
+    int status = run_trace_diff(2, args);
+    selftest_redirect(stdout, NULL, saved);
+
+    FILE *fp = fopen(report, "r");
+    if (!fp || !fgets(output, MAX_LINE_LENGTH, fp)) output[0] = '\0';
+    output[strcspn(output, "\n")] = '\0';
+    if (fp) fclose(fp);
+    unlink(report);
+    if (strcmp(name, "a")) { // the first trace stays for the next runs
+        unlink(trace);
+        rmdir(dir);
+    }
+    return status;
+}
+
+static void selftest_trace(SelfTest *test) { // one script replayed twice traces the same ticks, a changed key is found by --trace-diff
+    char script[MAX_PATH_LENGTH], output[MAX_LINE_LENGTH], expected[MAX_LINE_LENGTH];
+    char inputs[] = "aaawwwwwdddww" "ddwwwwdwwaaaaaaasssdddwsaaassssddw" // the solver's welcome & arena0, then random keys
+        "                                                                                                                        ";
+    uint64_t seed = 43;
+    for (char *key = strchr(inputs, ' '); *key; key++) *key = GAME_INPUTS[splitmix64(&seed) % (sizeof(GAME_INPUTS) - 1)];
+    selftest_path(test, "replay", script);
+    FILE *fp = fopen(script, "w");
+    int written = fp && fputs(inputs, fp) >= 0;
+    if (fp) fclose(fp);
+    SELFTEST_CHECK(test, written, "trace: writing %s", script);
+    if (!written) return;
+
+    BatchResult first, second, changed;
+    selftest_trace_run(test, script, "a", &first, output); // against itself
+    int status = selftest_trace_run(test, script, "b", &second, output);
+    snprintf(expected, sizeof(expected), "identical, %ld ticks", first.ticks);
+    SELFTEST_CHECK(test, status == EXIT_SUCCESS && !strcmp(output, expected), "trace: two runs of one script, --trace-diff says \"%s\"", output);
+    SELFTEST_CHECK(test, !memcmp(&first, &second, sizeof(first)), "trace: two runs of one script end differently");
+
+    inputs[first.ticks / 2] = inputs[first.ticks / 2] == 'w' ? 's' : 'w'; // somewhere in the middle of the run
+    if ((fp = fopen(script, "w"))) {
+        fputs(inputs, fp);
+        fclose(fp);
+    }
+    status = selftest_trace_run(test, script, "c", &changed, output);
+    SELFTEST_CHECK(test, status == EXIT_FAILURE && !strncmp(output, "diverged at tick ", 17), "trace: a changed key, --trace-diff says \"%s\"", output);
+
+    char path[MAX_PATH_LENGTH];
+    selftest_path(test, "a/replay.trace", path);
+    unlink(path);
+    selftest_path(test, "a", path);
+    rmdir(path);
+    unlink(script);
+}
+
+#ifdef __linux__
+static pthread_t selftest_game_thread;
+
+static void selftest_render_exit() { // atexit in the render children: exit() must come from the game thread, with stdout on the terminal
+    if (!pthread_equal(pthread_self(), selftest_game_thread)) _exit(3);
+    if (render.stream && stdout == render.stream) _exit(4);
+}
+
+static pid_t selftest_render_child(int *pipe_end, int close_reader) { // a child whose terminal is a pipe & whose frames go through the render thread
+    int fds[2];
+    if (pipe(fds) == -1) return -1;
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid) {
+        close(fds[1]);
+        if (pid == -1 || close_reader) close(fds[0]);
+        else *pipe_end = fds[0];
+        return pid;
+    }
+    close(fds[0]);
+    dup2(fds[1], STDOUT_FILENO);
+    close(fds[1]);
+    selftest_mute(-1);
+    signal(SIGPIPE, SIG_IGN); // a closed terminal shows up as EPIPE
+    selftest_game_thread = pthread_self();
+    atexit(selftest_render_exit);
+    setenv("TA_RENDER_THREAD", "1", 1);
+    render_init();
+    if (!render.enabled) _exit(2);
+    for (int f = 0; f < 300; f++) {
+        render_begin();
+        printf("frame %03d ", f);
+        for (int i = 0; i < 2000; i++) putchar('a' + (f + i) % 26);
+        putchar('\n');
+        render_submit();
+    }
+    render_drain();
+    _exit(EXIT_SUCCESS);
+}
+
+static void selftest_render(SelfTest *test) { // frames reach a slow pipe whole & in order, a closed pipe ends the game from its own thread
+    int reader = -1, status = 0;
+    pid_t pid = selftest_render_child(&reader, 0);
+    SELFTEST_CHECK(test, pid > 0, "render: fork");
+    if (pid <= 0) return;
+    size_t capacity = 300 * 2012, length = 0;
+    char *output = (char *)game_malloc(capacity + 1);
+    if (output == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (ssize_t got; length < capacity && (got = read(reader, output + length, capacity - length < 4096 ? capacity - length : 4096)) > 0; length += got) {
+        nanosleep(&(struct timespec){ 0, 500000 }, NULL); // about 8 MB/s, slower than the frames come
+    }
+    output[length] = '\0';
+    close(reader);
+    waitpid(pid, &status, 0);
+    SELFTEST_CHECK(test, WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS, "render: the child ended with status %d", status);
+
+    int frames = 0, last = -1, whole = length % 2011 == 0;
+    for (size_t at = 0; whole && at < length; at += 2011, frames++) {
+        int f = atoi(output + at + 6);
+        whole = !strncmp(output + at, "frame ", 6) && f > last && output[at + 2010] == '\n';
+        for (int i = 0; whole && i < 2000; i++) whole = output[at + 10 + i] == 'a' + (f + i) % 26;
+        last = f;
+    }
+    SELFTEST_CHECK(test, whole && last == 299, "render: %d frames in %zu bytes, last %d, not whole or out of order", frames, length, last);
+    game_free(output);
+
+    pid = selftest_render_child(&reader, 1); // nobody reads ~ the first write fails
+    if (pid > 0) waitpid(pid, &status, 0);
+    SELFTEST_CHECK(test, pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE, "render: a closed terminal ended the child with status %d", status);
+}
+#endif
+
+int run_selftest(int count, char *args[]) {
+    const SelfTestCase cases[] = {
+        {"solver", selftest_solver},
+        {"kernels", selftest_kernels},
+        {"leaderboard", selftest_leaderboard},
+        {"rle", selftest_rle},
+        {"journal", selftest_journal},
+        {"world", selftest_world},
+        {"small", selftest_small},
+        {"world_lazy", selftest_world_lazy},
+        {"trace", selftest_trace},
+#ifdef __linux__
+        {"render", selftest_render},
+#endif
+    };
+    int total = sizeof(cases) / sizeof(cases[0]);
+    if (count > 1 || (count == 1 && !strcmp(args[0], "--help"))) {
+        fprintf(stderr, "usage: --selftest [test], tests:");
+        for (int c = 0; c < total; c++) fprintf(stderr, " %s", cases[c].name);
+        fputc('\n', stderr);
+        return EXIT_FAILURE;
+    }
+
+    char dir[] = "/tmp/version1_selftestXXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+    int failed = 0, ran = 0;
+    for (int c = 0; c < total; c++) {
+        if (count && strcmp(args[0], cases[c].name)) continue;
+        SelfTest test = { dir, 0, 0 };
+        cases[c].run(&test);
+        printf("%-12s %s (%d checks)\n", cases[c].name, test.failures ? "FAILED" : "ok", test.checks);
+        failed += test.failures != 0;
+        ran++;
     }
+    rmdir(dir); // every test removes its own files
+    if (!ran) {
+        fprintf(stderr, "%s: no such test\n", args[0]);
+        return EXIT_FAILURE;
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /*
     MENUS & MESSAGES
+    (every screen is composed at compile time and shown with a single write)
 */
+static const char MAIN_MENU_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " ORANGE "M " RESET "|                 |\n"
+    "| " ORANGE "A " RESET "| Hello, User!    |\n"
+    "| " ORANGE "I " RESET "|                 |\n"
+    "| " ORANGE "N " RESET "| 1: New Game     |\n"
+    "| " ORANGE "- " RESET "| 2: Exit Game    |\n"
+    "| " ORANGE "M " RESET "|                 |\n"
+    "| " ORANGE "E " RESET "|                 |\n"
+    "| " ORANGE "N " RESET "|                 |\n"
+    "| " ORANGE "U " RESET "|                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char PAUSE_MENU_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " ORANGE "P " RESET "| ___             |\n"
+    "| " ORANGE "A " RESET "|                 |\n"
+    "| " ORANGE "U " RESET "| Tab: Return to  |\n"
+    "| " ORANGE "S " RESET "|      the arena  |\n"
+    "| " ORANGE "E " RESET "|                 |\n"
+    "| " ORANGE "- " RESET "| Esc: Go to the  |\n"
+    "| " ORANGE "M " RESET "|      main menu  |\n"
+    "| " ORANGE "E " RESET "| ___             |\n"
+    "| " ORANGE "N " RESET "|                 |\n"
+    "| " ORANGE "U " RESET "|                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL_MOVEMENT_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "W " RESET "|                 |\n"
+    "| " CYAN "E " RESET "| Use " GREEN "wasd" RESET " (or    |\n"
+    "| " CYAN "L " RESET "| uppercase " GREEN "WASD" RESET ") |\n"
+    "| " CYAN "C " RESET "| to " GREEN "move" RESET " the     |\n"
+    "| " CYAN "0 " RESET "| character!      |\n"
+    "| " CYAN "M " RESET "|                 |\n"
+    "| " CYAN "E " RESET "| Also, " YELLOW "TAB" RESET " can   |\n"
+    "| " YELLOW "! " RESET "| be used to      |\n"
+    "| = | " YELLOW "pause" RESET " the game. |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | to continue ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL0_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "U " RESET "| " YELLOW "1) DOORS & KEYS" RESET " |\n"
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "0 " RESET "| Sometimes paths |\n"
+    "| " CYAN "R " RESET "| are blocked by  |\n"
+    "| " CYAN "I " RESET "| " DARK_GRAY "doors" RESET " (" DARK_GRAY "d" RESET ").      |\n"
+    "| " CYAN "A " RESET "|                 |\n"
+    "| " CYAN "L " RESET "| Collect the " YELLOW "key" RESET " |\n"
+    "| = | (" YELLOW "k" RESET ") to unlock   |\n"
+    "| = | them!           |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | to continue ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL1_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "U " RESET "| " YELLOW "2) EXIT DOORS" RESET "   |\n"
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "0 " RESET "| If the arena    |\n"
+    "| " CYAN "R " RESET "| " YELLOW "exit door" RESET " (" YELLOW "#" RESET ")   |\n"
+    "| " CYAN "I " RESET "| is " DARK_GRAY "locked" RESET " (" DARK_GRAY "D" RESET "),  |\n"
+    "| " CYAN "A " RESET "| collect the " YELLOW "end" RESET " |\n"
+    "| " CYAN "L " RESET "| " YELLOW "key" RESET " (" YELLOW "K" RESET ").        |\n"
+    "| = |                 |\n"
+    "| = | This " YELLOW "special" RESET "    |\n"
+    "| = | " YELLOW "key" RESET " can open    |\n"
+    "| = | both " DARK_GRAY "exit" RESET " and   |\n"
+    "| = | " DARK_GRAY "path doors" RESET " (" DARK_GRAY "d" RESET "). |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | to continue ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL_HEALTH_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "U " RESET "| " YELLOW "3) HEALTH    " RESET "   |\n"
+    "| " CYAN "T " RESET "| " YELLOW "   SYSTEM" RESET "       |\n"
+    "| " CYAN "0 " RESET "|                 |\n"
+    "| " CYAN "R " RESET "|  = = = =        |\n"
+    "| " CYAN "I " RESET "|  |" GREEN "H:100" RESET "|        |\n"
+    "| " CYAN "A " RESET "|  = = = =        |\n"
+    "| " CYAN "L " RESET "|                 |\n"
+    "| = | " RED "Enemies" RESET " and     |\n"
+    "| = | " RED "traps" RESET " reduce    |\n"
+    "| = | your health.    |\n"
+    "| = |                 |\n"
+    "| = | If it hits " RED "0" RESET ",   |\n"
+    "| = | you'll " RED "die!" RESET "     |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | to continue ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL2_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "U " RESET "| " YELLOW "4) SPIKES" RESET "       |\n"
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "0 " RESET "| If you step on  |\n"
+    "| " CYAN "R " RESET "| " RED "spikes" RESET " (" RED "x" RESET "),     |\n"
+    "| " CYAN "I " RESET "| your health     |\n"
+    "| " CYAN "A " RESET "| will " RED "decrease" RESET "   |\n"
+    "| " CYAN "L " RESET "| by " RED "30" RESET ".          |\n"
+    "| = |                 |\n"
+    "| = | " YELLOW "Items" RESET " improve   |\n"
+    "| = | your defense    |\n"
+    "| = | againts " RED "spikes!" RESET " |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | to continue ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL_INVENTORY_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "U " RESET "| " YELLOW "5) ITEMS       " RESET " |\n"
+    "| " CYAN "T " RESET "| " YELLOW "& INVENTORY    " RESET " |\n"
+    "| " CYAN "0 " RESET "|                 |\n"
+    "| " CYAN "R " RESET "|  = = = = = = =  |\n"
+    "| " CYAN "I " RESET "|  |" ORANGE "[" RESET LIGHT_ORANGE "1" RESET ORANGE "]" RESET "|" ORANGE "[" RESET LIGHT_ORANGE "2" RESET ORANGE "]" RESET "|" ORANGE "[" RESET LIGHT_ORANGE "3" RESET ORANGE "]" RESET "|  |\n"
+    "| " CYAN "A " RESET "|  = = = = = = =  |\n"
+    "| " CYAN "L " RESET "|                 |\n"
+    "| = | " YELLOW "Items" RESET " help you  |\n"
+    "| = | get through the |\n"
+    "| = | the arenas more |\n"
+    "| = | easily.         |\n"
+    "| = |                 |\n"
+    "| = | Use them by     |\n"
+    "| = | pressing " LIGHT_ORANGE "1" RESET ", " LIGHT_ORANGE "2" RESET "   |\n"
+    "| = | or " LIGHT_ORANGE "3" RESET " for their  |\n"
+    "| = | corresponding   |\n"
+    "| = | " YELLOW "inventory slot." RESET " |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | to continue ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL3_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "U " RESET "| " YELLOW "6) HEALTH" RESET "       |\n"
+    "| " CYAN "T " RESET "|    " YELLOW "PICKUP" RESET "       |\n"
+    "| " CYAN "0 " RESET "|                 |\n"
+    "| " CYAN "R " RESET "| Your health is  |\n"
+    "| " CYAN "I " RESET "| " RED "low?" RESET "            |\n"
+    "| " CYAN "A " RESET "|                 |\n"
+    "| " CYAN "L " RESET "| Pick up " GREEN "health" RESET "  |\n"
+    "| = | " GREEN "increase" RESET " (" GREEN "+" RESET ")    |\n"
+    "| = | and restore     |\n"
+    "| = | your health!    |\n"
+    "| = |                 |\n"
+    "| = | Without any     |\n"
+    "| = | upgrades, this  |\n"
+    "| = | " YELLOW "consumable" RESET " will |\n"
+    "| = | give you " GREEN "+15 H." RESET " |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | to continue ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL4_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "U " RESET "| " YELLOW "7) HOLES" RESET "        |\n"
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "0 " RESET "| " RED "Holes" RESET " appeared  |\n"
+    "| " CYAN "R " RESET "| out of nowhere. |\n"
+    "| " CYAN "I " RESET "|                 |\n"
+    "| " CYAN "A " RESET "| Falling into a  |\n"
+    "| " CYAN "L " RESET "| a " RED "big hole" RESET " (" RED "O" RESET ")  |\n"
+    "| = | means instant   |\n"
+    "| = | " RED "death!" RESET "          |\n"
+    "| = |                 |\n"
+    "| = | " RED "Small holes" RESET " (" RED "o" RESET ") |\n"
+    "| = | will not give   |\n"
+    "| = | you any damage  |\n"
+    "| = | " YELLOW "BUT" RESET " all your    |\n"
+    "| = | items will be   |\n"
+    "| = | " YELLOW "lost" RESET " :)         |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | to continue ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char TUTORIAL_FAIL_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "U " RESET "| " BRIGHT_RED "YOU ARE DEAD!" RESET "   |\n"
+    "| " CYAN "T " RESET "|                 |\n"
+    "| " CYAN "0 " RESET "| Press any key   |\n"
+    "| " CYAN "R " RESET "| to restart this |\n"
+    "| " CYAN "I " RESET "| tutorial arena  |\n"
+    "| " CYAN "A " RESET "| ...             |\n"
+    "| " CYAN "L " RESET "|                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char SPIKE_DEATH_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " RED "G " RESET "|                 |\n"
+    "| " RED "A " RESET "| " BRIGHT_RED "YOU ARE DEAD!" RESET "   |\n"
+    "| " RED "M " RESET "|                 |\n"
+    "| " RED "E " RESET "| An ordinary     |\n"
+    "| " RED "- " RESET "| spike took your |\n"
+    "| " RED "O " RESET "| life :)         |\n"
+    "| " RED "V " RESET "|                 |\n"
+    "| " RED "E " RESET "| Press any key   |\n"
+    "| " RED "R " RESET "| and return back |\n"
+    "| = | to the main     |\n"
+    "| = | menu ...        |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char HOLE_DEATH_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " RED "G " RESET "|                 |\n"
+    "| " RED "A " RESET "| " BRIGHT_RED "YOU ARE DEAD!" RESET "   |\n"
+    "| " RED "M " RESET "|                 |\n"
+    "| " RED "E " RESET "| It looks like   |\n"
+    "| " RED "- " RESET "| you fell into a |\n"
+    "| " RED "O " RESET "| very big hole!  |\n"
+    "| " RED "V " RESET "|                 |\n"
+    "| " RED "E " RESET "| Press any key   |\n"
+    "| " RED "R " RESET "| and return back |\n"
+    "| = | to the main     |\n"
+    "| = | menu ...        |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char WARRIOR_DEATH_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " RED "G " RESET "|                 |\n"
+    "| " RED "A " RESET "| " BRIGHT_RED "YOU ARE DEAD!" RESET "   |\n"
+    "| " RED "M " RESET "|                 |\n"
+    "| " RED "E " RESET "| Warriors are    |\n"
+    "| " RED "- " RESET "| hard to defeat  |\n"
+    "| " RED "O " RESET "| if you are not  |\n"
+    "| " RED "V " RESET "| skilled!        |\n"
+    "| " RED "E " RESET "|                 |\n"
+    "| " RED "R " RESET "| Press any key   |\n"
+    "| = | and return back |\n"
+    "| = | to the main     |\n"
+    "| = | menu ...        |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char EXIT_MESSAGE_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " ORANGE "M " RESET "|                 |\n"
+    "| " ORANGE "A " RESET "| Are you sure    |\n"
+    "| " ORANGE "I " RESET "| about leaving   |\n"
+    "| " ORANGE "N " RESET "| the game?  " YELLOW ":(" RESET "   |\n"
+    "| " ORANGE "- " RESET "|                 |\n"
+    "| " ORANGE "M " RESET "| Press " RED "Y" RESET " or " RED "y" RESET " to |\n"
+    "| " ORANGE "E " RESET "| " RED "exit" RESET " the game.  |\n"
+    "| " ORANGE "N " RESET "|                 |\n"
+    "| " ORANGE "U " RESET "| Press any other |\n"
+    "| = | key to " GREEN "stay" RESET " ... |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char WIN_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " GREEN "V " RESET "|                 |\n"
+    "| " GREEN "I " RESET "| " BRIGHT_GREEN "CONGRATULATIONS" RESET " |\n"
+    "| " GREEN "C " RESET "|                 |\n"
+    "| " GREEN "T " RESET "| You completed   |\n"
+    "| " GREEN "O " RESET "| all the arenas! |\n"
+    "| " GREEN "R " RESET "|                 |\n"
+    "| " GREEN "Y " RESET "| Thank you for   |\n"
+    "| " YELLOW "! " RESET "| playing " YELLOW "v.1.0" RESET "   |\n"
+    "| = |                 |\n"
+    "| = | Press any key   |\n"
+    "| = | and return back |\n"
+    "| = | to the main     |\n"
+    "| = | menu ...        |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
+static const char ASK_ABOUT_TUTORIAL_SCREEN[] = CLEAR_SCREEN SCREEN_TITLE
+    "| " ORANGE "M " RESET "|                 |\n"
+    "| " ORANGE "A " RESET "| Do you want     |\n"
+    "| " ORANGE "I " RESET "| to play the     |\n"
+    "| " ORANGE "N " RESET "| tutorial?       |\n"
+    "| " ORANGE "- " RESET "| (" GREEN "recommended" RESET ")   |\n"
+    "| " ORANGE "M " RESET "|                 |\n"
+    "| " ORANGE "E " RESET "| Press " GREEN "Y" RESET " or " GREEN "y" RESET " to |\n"
+    "| " ORANGE "N " RESET "| for playing it. |\n"
+    "| " ORANGE "U " RESET "|                 |\n"
+    "| = | Press " YELLOW "N" RESET " or " YELLOW "n" RESET "    |\n"
+    "| = | for starting    |\n"
+    "| = | without it.     |\n"
+    "| = |                 |\n"
+    "| = | Press any other |\n"
+    "| = | key to return   |\n"
+    "| = | back ...        |\n"
+    "| = |                 |\n"
+    "= = = = = = = = = = = =\n";
+
 void display_main_menu() {
     while(1) {
-        clear_console();
-        printf("= = = = = = = = = = = =\n|"); 
-        printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-        printf("= = = = = = = = = = = =\n"); 
-        printf("|"); printf(" %sM %s", ORANGE, RESET); printf("|                 |\n");
-        printf("|"); printf(" %sA %s", ORANGE, RESET); printf("| Hello, User!    |\n"); 
-        printf("|"); printf(" %sI %s", ORANGE, RESET); printf("|                 |\n"); 
-        printf("|"); printf(" %sN %s", ORANGE, RESET); printf("| 1: New Game     |\n");
-        printf("|"); printf(" %s- %s", ORANGE, RESET); printf("| 2: Exit Game    |\n");
-        printf("|"); printf(" %sM %s", ORANGE, RESET); printf("|                 |\n");
-        printf("|"); printf(" %sE %s", ORANGE, RESET); printf("|                 |\n");
-        printf("|"); printf(" %sN %s", ORANGE, RESET); printf("|                 |\n");
-        printf("|"); printf(" %sU %s", ORANGE, RESET); printf("|                 |\n"); 
-        printf("= = = = = = = = = = = =\n");
+        SHOW_SCREEN(MAIN_MENU_SCREEN);
 
         char input;
         input = getchar();
@@ -979,21 +6734,7 @@ void display_main_menu() {
  
 int display_pause_menu() {
     while(1) {
-        clear_console();
-        printf("= = = = = = = = = = = =\n|"); 
-        printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-        printf("= = = = = = = = = = = =\n"); 
-        printf("|"); printf(" %sP %s", ORANGE, RESET); printf("| ___             |\n");
-        printf("|"); printf(" %sA %s", ORANGE, RESET); printf("|                 |\n"); 
-        printf("|"); printf(" %sU %s", ORANGE, RESET); printf("| Tab: Return to  |\n"); 
-        printf("|"); printf(" %sS %s", ORANGE, RESET); printf("|      the arena  |\n");
-        printf("|"); printf(" %sE %s", ORANGE, RESET); printf("|                 |\n");
-        printf("|"); printf(" %s- %s", ORANGE, RESET); printf("| Esc: Go to the  |\n");
-        printf("|"); printf(" %sM %s", ORANGE, RESET); printf("|      main menu  |\n");
-        printf("|"); printf(" %sE %s", ORANGE, RESET); printf("| ___             |\n");
-        printf("|"); printf(" %sN %s", ORANGE, RESET); printf("|                 |\n"); 
-        printf("|"); printf(" %sU %s", ORANGE, RESET); printf("|                 |\n"); 
-        printf("= = = = = = = = = = = =\n");
+        SHOW_SCREEN(PAUSE_MENU_SCREEN);
 
         char input;
         input = getchar();
@@ -1016,329 +6757,103 @@ int display_pause_menu() {
 }
 
 void display_tutorial_movement() { // tutorial message for movement
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sW %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sE %s", CYAN, RESET); printf("| Use "); printf("%swasd%s", GREEN, RESET); printf(" (or    |\n");
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("| uppercase "); printf("%sWASD%s", GREEN, RESET); printf(") |\n");
-    printf("|"); printf(" %sC %s", CYAN, RESET); printf("| to "); printf("%smove%s", GREEN, RESET); printf(" the     |\n");
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("| character!      |\n");
-    printf("|"); printf(" %sM %s", CYAN, RESET); printf("|                 |\n"); 
-    printf("|"); printf(" %sE %s", CYAN, RESET); printf("| Also, "); printf("%sTAB%s", YELLOW, RESET); printf(" can   |\n");
-    printf("|"); printf(" %s! %s", YELLOW, RESET); printf("| be used to      |\n");
-    printf("| = | "); printf("%spause%s", YELLOW, RESET); printf(" the game. |\n"); printf("| = |                 |\n"); 
-    printf("| = | Press any key   |\n"); printf("| = | to continue ... |\n"); 
-    printf("| = |                 |\n"); printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL_MOVEMENT_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_tutorial0() { // tutorial message for the first tutorial arena
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", CYAN, RESET); printf("| "); printf("%s1) DOORS & KEYS%s", YELLOW, RESET); printf(" |\n");
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n"); 
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("| Sometimes paths |\n");
-    printf("|"); printf(" %sR %s", CYAN, RESET); printf("| are blocked by  |\n");
-    printf("|"); printf(" %sI %s", CYAN, RESET); printf("| "); printf("%sdoors%s", DARK_GRAY, RESET); printf(" ("); printf("%sd%s", DARK_GRAY, RESET); printf(").      |\n");
-    printf("|"); printf(" %sA %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("| Collect the "); printf("%skey%s", YELLOW, RESET); printf(" |\n");
-    printf("| = | ("); printf("%sk%s", YELLOW, RESET); printf(") to unlock   |\n");
-    printf("| = | them!           |\n"); printf("| = |                 |\n"); 
-    printf("| = | Press any key   |\n"); printf("| = | to continue ... |\n");
-    printf("| = |                 |\n"); printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL0_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_tutorial1() { // tutorial message for the second tutorial arena
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", CYAN, RESET); printf("| "); printf("%s2) EXIT DOORS%s", YELLOW, RESET); printf("   |\n");
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("| If the arena    |\n");
-    printf("|"); printf(" %sR %s", CYAN, RESET); printf("| "); printf("%sexit door%s", YELLOW, RESET); printf(" ("); printf("%s#%s", YELLOW, RESET); printf(")   |\n");
-    printf("|"); printf(" %sI %s", CYAN, RESET); printf("| is "); printf("%slocked%s", DARK_GRAY, RESET); printf(" ("); printf("%sD%s", DARK_GRAY, RESET); printf("),  |\n");
-    printf("|"); printf(" %sA %s", CYAN, RESET); printf("| collect the "); printf("%send%s", YELLOW, RESET); printf(" |\n"); 
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("| "); printf("%skey%s", YELLOW, RESET); printf(" ("); printf("%sK%s", YELLOW, RESET); printf(").        |\n");
-    printf("| = |                 |\n"); printf("| = | This "); printf("%sspecial%s", YELLOW, RESET); printf("    |\n");
-    printf("| = | "); printf("%skey%s", YELLOW, RESET); printf(" can open    |\n"); printf("| = | both "); printf("%sexit%s", DARK_GRAY, RESET); printf(" and   |\n");
-    printf("| = | "); printf("%spath doors%s", DARK_GRAY, RESET); printf(" ("); printf("%sd%s", DARK_GRAY, RESET); printf("). |\n"); 
-    printf("| = |                 |\n"); printf("| = | Press any key   |\n"); 
-    printf("| = | to continue ... |\n"); printf("| = |                 |\n");
-    printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL1_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_tutorial_health() { // tutorial message for the health system
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", CYAN, RESET); printf("| "); printf("%s3) HEALTH    %s", YELLOW, RESET); printf("   |\n");
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("| "); printf("%s   SYSTEM%s", YELLOW, RESET); printf("       |\n");
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sR %s", CYAN, RESET); printf("|  = = = =        |\n");
-    printf("|"); printf(" %sI %s", CYAN, RESET); printf("|  |"); printf("%sH:100%s", GREEN, RESET); printf("|        |\n");
-    printf("|"); printf(" %sA %s", CYAN, RESET); printf("|  = = = =        |\n");
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("|                 |\n");
-    printf("| = | ");  printf("%sEnemies%s", RED, RESET); printf(" and     |\n"); printf("| = | "); printf("%straps%s", RED, RESET);printf(" reduce    |\n");
-    printf("| = | your health.    |\n"); printf("| = |                 |\n");
-    printf("| = | If it hits "); printf("%s0%s", RED, RESET); printf(",   |\n");
-    printf("| = | you'll "); printf("%sdie!%s", RED, RESET); printf("     |\n"); 
-    printf("| = |                 |\n"); printf("| = | Press any key   |\n"); 
-    printf("| = | to continue ... |\n"); printf("| = |                 |\n");
-    printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL_HEALTH_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_tutorial2() { // tutorial message for the third tutorial arena
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", CYAN, RESET); printf("| "); printf("%s4) SPIKES%s", YELLOW, RESET); printf("       |\n");
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("| If you step on  |\n"); 
-    printf("|"); printf(" %sR %s", CYAN, RESET); printf("| "); printf("%sspikes%s", RED, RESET); printf(" ("); printf("%sx%s", RED, RESET); printf("),     |\n");
-    printf("|"); printf(" %sI %s", CYAN, RESET); printf("| your health     |\n"); 
-    printf("|"); printf(" %sA %s", CYAN, RESET); printf("| will "); printf("%sdecrease%s", RED, RESET); printf("   |\n");
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("| by "); printf("%s30%s", RED, RESET); printf(".          |\n");
-    printf("| = |                 |\n"); printf("| = | "); printf("%sItems%s", YELLOW, RESET); printf(" improve   |\n");
-    printf("| = | your defense    |\n"); printf("| = | againts "); printf("%sspikes!%s", RED, RESET); printf(" |\n");
-    printf("| = |                 |\n"); printf("| = | Press any key   |\n");
-    printf("| = | to continue ... |\n"); printf("| = |                 |\n");
-    printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL2_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_tutorial_inventory() { // tutorial message for the inventory system
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", CYAN, RESET); printf("| "); printf("%s5) ITEMS       %s", YELLOW, RESET); printf(" |\n");
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("| "); printf("%s& INVENTORY    %s", YELLOW, RESET); printf(" |\n"); 
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sR %s", CYAN, RESET); printf("|  = = = = = = =  |\n");
-    printf("|"); printf(" %sI %s", CYAN, RESET); printf("|  |"); printf("%s[%s", ORANGE, RESET); printf("%s1%s", LIGHT_ORANGE, RESET); 
-        printf("%s]%s", ORANGE, RESET); printf("|"); printf("%s[%s", ORANGE, RESET); printf("%s2%s", LIGHT_ORANGE, RESET); printf("%s]%s", ORANGE, RESET); 
-        printf("|"); printf("%s[%s", ORANGE, RESET); printf("%s3%s", LIGHT_ORANGE, RESET); printf("%s]%s", ORANGE, RESET);  printf("|  |\n");
-    printf("|"); printf(" %sA %s", CYAN, RESET); printf("|  = = = = = = =  |\n");
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("|                 |\n");
-    printf("| = | "); printf("%sItems%s", YELLOW, RESET); printf(" help you  |\n"); printf("| = | get through the |\n");
-    printf("| = | the arenas more |\n"); printf("| = | easily.         |\n");
-    printf("| = |                 |\n"); printf("| = | Use them by     |\n"); 
-    printf("| = | pressing "); printf("%s1%s", LIGHT_ORANGE, RESET); printf(", "); printf("%s2%s", LIGHT_ORANGE, RESET); printf("   |\n");
-    printf("| = | or "); printf("%s3%s", LIGHT_ORANGE, RESET); printf(" for their  |\n"); 
-    printf("| = | corresponding   |\n"); printf("| = | "); printf("%sinventory slot.%s", YELLOW, RESET); printf(" |\n");
-    printf("| = |                 |\n"); printf("| = | Press any key   |\n"); printf("| = | to continue ... |\n"); 
-    printf("| = |                 |\n"); printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL_INVENTORY_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_tutorial3() { // tutorial message for the fourth tutorial arena
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", CYAN, RESET); printf("| "); printf("%s6) HEALTH%s", YELLOW, RESET); printf("       |\n");
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|    "); printf("%sPICKUP%s", YELLOW, RESET); printf("       |\n");
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("|                 |\n"); 
-    printf("|"); printf(" %sR %s", CYAN, RESET); printf("| Your health is  |\n"); 
-    printf("|"); printf(" %sI %s", CYAN, RESET); printf("| "); printf("%slow?%s", RED, RESET); printf("            |\n");
-    printf("|"); printf(" %sA %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("| Pick up "); printf("%shealth%s", GREEN, RESET); printf("  |\n");
-    printf("| = | "); printf("%sincrease%s", GREEN, RESET); printf(" ("); printf("%s+%s", GREEN, RESET); printf(")    |\n");
-    printf("| = | and restore     |\n");
-    printf("| = | your health!    |\n");
-    printf("| = |                 |\n"); printf("| = | Without any     |\n"); 
-    printf("| = | upgrades, this  |\n"); printf("| = | "); printf("%sconsumable%s", YELLOW, RESET);  printf(" will |\n");
-    printf("| = | give you "); printf("%s+15 H.%s", GREEN, RESET); printf(" |\n");
-    printf("| = |                 |\n"); printf("| = | Press any key   |\n"); 
-    printf("| = | to continue ... |\n"); printf("| = |                 |\n"); 
-    printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL3_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_tutorial4() { // tutorial message for the fifth tutorial arena
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", CYAN, RESET); printf("| "); printf("%s7) HOLES%s", YELLOW, RESET); printf("        |\n");
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("| "); printf("%sHoles%s", RED, RESET); printf(" appeared  |\n");
-    printf("|"); printf(" %sR %s", CYAN, RESET); printf("| out of nowhere. |\n");
-    printf("|"); printf(" %sI %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sA %s", CYAN, RESET); printf("| Falling into a  |\n"); 
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("| a "); printf("%sbig hole%s", RED, RESET); printf(" ("); printf("%sO%s", RED, RESET); printf(")  |\n");
-    printf("| = | means instant   |\n"); printf("| = | ");  printf("%sdeath!%s", RED, RESET); printf("          |\n");
-    printf("| = |                 |\n"); printf("| = | "); printf("%sSmall holes%s", RED, RESET); printf(" ("); printf("%so%s", RED, RESET); printf(") |\n");
-    printf("| = | will not give   |\n"); printf("| = | you any damage  |\n");
-    printf("| = | "); printf("%sBUT%s", YELLOW, RESET); printf(" all your    |\n"); printf("| = | items will be   |\n");  
-    printf("| = | "); printf("%slost%s", YELLOW, RESET); printf(" :)         |\n"); printf("| = |                 |\n"); 
-    printf("| = | Press any key   |\n"); printf("| = | to continue ... |\n"); 
-    printf("| = |                 |\n"); printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL4_SCREEN);
     getchar(); 
     clear_console();
 }
 
+static const struct { const char *name; void (*show)(); } TRIGGER_SCREENS[] = { // what a "screen" trigger can name
+    {"movement", display_tutorial_movement}, {"tutorial0", display_tutorial0}, {"tutorial1", display_tutorial1}, {"tutorial2", display_tutorial2},
+    {"tutorial3", display_tutorial3}, {"tutorial4", display_tutorial4}, {"health", display_tutorial_health}, {"inventory", display_tutorial_inventory},
+};
+
+int trigger_screen(const char *name) {
+    for (int i = 0; i < (int)(sizeof(TRIGGER_SCREENS) / sizeof(TRIGGER_SCREENS[0])); i++) if (!strcmp(name, TRIGGER_SCREENS[i].name)) return i;
+    return -1;
+}
+
+void display_trigger_screen(int screen) {
+    TRIGGER_SCREENS[screen].show();
+}
+
 void display_tutorial_fail() { // message displayed when the tutorial is failed 
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", CYAN, RESET); printf("| "); printf("%sYOU ARE DEAD!%s", BRIGHT_RED, RESET); printf("   |\n");
-    printf("|"); printf(" %sT %s", CYAN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %s0 %s", CYAN, RESET); printf("| Press any key   |\n"); 
-    printf("|"); printf(" %sR %s", CYAN, RESET); printf("| to restart this |\n");
-    printf("|"); printf(" %sI %s", CYAN, RESET); printf("| tutorial arena  |\n");
-    printf("|"); printf(" %sA %s", CYAN, RESET); printf("| ...             |\n");
-    printf("|"); printf(" %sL %s", CYAN, RESET); printf("|                 |\n"); 
-    printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(TUTORIAL_FAIL_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_spike_death() { // death message for spikes
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sG %s", RED, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sA %s", RED, RESET); printf("| "); printf("%sYOU ARE DEAD!%s", BRIGHT_RED, RESET); printf("   |\n");
-    printf("|"); printf(" %sM %s", RED, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sE %s", RED, RESET); printf("| An ordinary     |\n"); 
-    printf("|"); printf(" %s- %s", RED, RESET); printf("| spike took your |\n");
-    printf("|"); printf(" %sO %s", RED, RESET); printf("| life :)         |\n");
-    printf("|"); printf(" %sV %s", RED, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sE %s", RED, RESET); printf("| Press any key   |\n"); 
-    printf("|"); printf(" %sR %s", RED, RESET); printf("| and return back |\n"); 
-    printf("| = | to the main     |\n"); printf("| = | menu ...        |\n"); 
-    printf("| = |                 |\n"); printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(SPIKE_DEATH_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_hole_death() { // death message for holes
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sG %s", RED, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sA %s", RED, RESET); printf("| "); printf("%sYOU ARE DEAD!%s", BRIGHT_RED, RESET); printf("   |\n");
-    printf("|"); printf(" %sM %s", RED, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sE %s", RED, RESET); printf("| It looks like   |\n"); 
-    printf("|"); printf(" %s- %s", RED, RESET); printf("| you fell into a |\n");
-    printf("|"); printf(" %sO %s", RED, RESET); printf("| very big hole!  |\n");
-    printf("|"); printf(" %sV %s", RED, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sE %s", RED, RESET); printf("| Press any key   |\n"); 
-    printf("|"); printf(" %sR %s", RED, RESET); printf("| and return back |\n"); 
-    printf("| = | to the main     |\n"); printf("| = | menu ...        |\n"); 
-    printf("| = |                 |\n"); printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(HOLE_DEATH_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_warrior_death() { // death message for warriors
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sG %s", RED, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sA %s", RED, RESET); printf("| "); printf("%sYOU ARE DEAD!%s", BRIGHT_RED, RESET); printf("   |\n");
-    printf("|"); printf(" %sM %s", RED, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sE %s", RED, RESET); printf("| Warriors are    |\n"); 
-    printf("|"); printf(" %s- %s", RED, RESET); printf("| hard to defeat  |\n");
-    printf("|"); printf(" %sO %s", RED, RESET); printf("| if you are not  |\n");
-    printf("|"); printf(" %sV %s", RED, RESET); printf("| skilled!        |\n");
-    printf("|"); printf(" %sE %s", RED, RESET); printf("|                 |\n"); 
-    printf("|"); printf(" %sR %s", RED, RESET); printf("| Press any key   |\n"); 
-    printf("| = | and return back |\n"); printf("| = | to the main     |\n"); 
-    printf("| = | menu ...        |\n"); printf("| = |                 |\n"); 
-    printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(WARRIOR_DEATH_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void display_exit_message() { // message displayed when exiting the game
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sM %s", ORANGE, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sA %s", ORANGE, RESET); printf("| Are you sure    |\n");
-    printf("|"); printf(" %sI %s", ORANGE, RESET); printf("| about leaving   |\n");
-    printf("|"); printf(" %sN %s", ORANGE, RESET); printf("| the game?  "); printf("%s:(%s", YELLOW, RESET); printf("   |\n");
-    printf("|"); printf(" %s- %s", ORANGE, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sM %s", ORANGE, RESET); printf("| Press "); printf("%sY%s", RED, RESET); printf(" or "); printf("%sy%s", RED, RESET); printf(" to |\n");
-    printf("|"); printf(" %sE %s", ORANGE, RESET); printf("| "); printf("%sexit%s", RED, RESET); printf(" the game.  |\n");
-    printf("|"); printf(" %sN %s", ORANGE, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sU %s", ORANGE, RESET); printf("| Press any other |\n"); 
-    printf("| = | key to ");  printf("%sstay%s", GREEN, RESET); printf(" ... |\n");
-    printf("| = |                 |\n"); printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(EXIT_MESSAGE_SCREEN);
 }
 
 void display_win() { // message displayed when finishing all arenas
-    clear_console(); 
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sV %s", GREEN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sI %s", GREEN, RESET); printf("| "); printf("%sCONGRATULATIONS%s", BRIGHT_GREEN, RESET); printf(" |\n");
-    printf("|"); printf(" %sC %s", GREEN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sT %s", GREEN, RESET); printf("| You completed   |\n"); 
-    printf("|"); printf(" %sO %s", GREEN, RESET); printf("| all the arenas! |\n");
-    printf("|"); printf(" %sR %s", GREEN, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sY %s", GREEN, RESET); printf("| Thank you for   |\n");
-    printf("|"); printf(" %s! %s", YELLOW, RESET); printf("| playing "); printf("%sv.1.0%s", YELLOW, RESET); printf("   |\n"); 
-    printf("| = |                 |\n"); printf("| = | Press any key   |\n"); 
-    printf("| = | and return back |\n"); printf("| = | to the main     |\n"); 
-    printf("| = | menu ...        |\n"); printf("| = |                 |\n"); 
-    printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(WIN_SCREEN);
     getchar(); 
     clear_console();
 }
 
 void ask_about_tutorial() { // message that asks the user if he wants to play the tutorial
-    clear_console();
-    printf("= = = = = = = = = = = =\n|"); 
-    printf(" %s  _TEXT_ADVENTURE_  %s", ORANGE, RESET); printf("|\n");
-    printf("= = = = = = = = = = = =\n"); 
-    printf("|"); printf(" %sM %s", ORANGE, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sA %s", ORANGE, RESET); printf("| Do you want     |\n"); 
-    printf("|"); printf(" %sI %s", ORANGE, RESET); printf("| to play the     |\n"); 
-    printf("|"); printf(" %sN %s", ORANGE, RESET); printf("| tutorial?       |\n");
-    printf("|"); printf(" %s- %s", ORANGE, RESET); printf("| ("); printf("%srecommended%s", GREEN, RESET); printf(")   |\n");
-    printf("|"); printf(" %sM %s", ORANGE, RESET); printf("|                 |\n");
-    printf("|"); printf(" %sE %s", ORANGE, RESET); printf("| Press "); printf("%sY%s", GREEN, RESET); printf(" or "); printf("%sy%s", GREEN, RESET); printf(" to |\n");
-    printf("|"); printf(" %sN %s", ORANGE, RESET); printf("| for playing it. |\n");
-    printf("|"); printf(" %sU %s", ORANGE, RESET); printf("|                 |\n"); 
-    printf("| = | Press "); printf("%sN%s", YELLOW, RESET); printf(" or "); printf("%sn%s", YELLOW, RESET); printf("    |\n"); printf("| = | for starting    |\n"); 
-    printf("| = | without it.     |\n"); printf("| = |                 |\n"); 
-    printf("| = | Press any other |\n"); printf("| = | key to return   |\n"); 
-    printf("| = | back ...        |\n"); printf("| = |                 |\n"); 
-    printf("= = = = = = = = = = = =\n");
+    SHOW_SCREEN(ASK_ABOUT_TUTORIAL_SCREEN);
 }
 
 